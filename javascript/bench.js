@@ -0,0 +1,225 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { execSync } from 'child_process';
+import { fileURLToPath } from 'url';
+import { performance, PerformanceObserver } from 'perf_hooks';
+import { parse, stringify } from './index.js';
+
+// Usage: node --expose-gc bench.js [--quick] [--filter <text>] [--out <file>] [--compare <file>]
+
+const here = path.dirname(fileURLToPath(import.meta.url));
+const args = process.argv.slice(2);
+const option = name => {
+  const index = args.indexOf(name);
+  return index === -1 ? undefined : args[index + 1];
+};
+const quick = args.includes('--quick');
+const filter = option('--filter');
+const minTime = quick ? 200 : 1000;
+
+// Benchmark documents
+
+function exampleDocuments() {
+  const dir = path.join(here, '..', 'examples');
+  if (!fs.existsSync(dir)) return [];
+  return fs.readdirSync(dir)
+    .filter(file => file.endsWith('.taml'))
+    .sort()
+    .map(file => ({ name: `examples/${file}`, text: fs.readFileSync(path.join(dir, file), 'utf8') }));
+}
+
+// Many records, like an exported table
+function largeDocument(records) {
+  const lines = ['users'];
+  for (let i = 0; i < records; i++) {
+    lines.push('\tuser');
+    lines.push(`\t\tid\t${i}`);
+    lines.push(`\t\tname\tUser ${i}`);
+    lines.push(`\t\temail\tuser${i}@example.com`);
+    lines.push(`\t\tactive\t${i % 3 !== 0}`);
+    lines.push(`\t\tscore\t${(i * 1.37).toFixed(2)}`);
+    lines.push(`\t\tcreated\t2024-01-${String(1 + i % 28).padStart(2, '0')}`);
+    lines.push('\t\troles');
+    lines.push('\t\t\tviewer');
+    if (i % 5 === 0) lines.push('\t\t\teditor');
+  }
+  return lines.join('\n');
+}
+
+// One long chain of nested objects
+function deepDocument(depth) {
+  const lines = [];
+  for (let i = 0; i < depth; i++) {
+    lines.push('\t'.repeat(i) + `level${i}`);
+    lines.push('\t'.repeat(i + 1) + `value\t${i}`);
+  }
+  return lines.join('\n');
+}
+
+// A few containers with very many direct children
+function wideDocument(width) {
+  const lines = ['settings'];
+  for (let i = 0; i < width; i++) {
+    lines.push(`\tkey${i}\tvalue ${i}`);
+  }
+  lines.push('tags');
+  for (let i = 0; i < width; i++) {
+    lines.push(`\ttag${i}`);
+  }
+  return lines.join('\n');
+}
+
+function documents() {
+  const scale = quick ? 0.1 : 1;
+  return [
+    ...exampleDocuments(),
+    { name: 'generated/large', text: largeDocument(Math.round(100000 * scale)) },
+    { name: 'generated/deep', text: deepDocument(Math.round(2000 * scale)) },
+    { name: 'generated/wide', text: wideDocument(Math.round(100000 * scale)) }
+  ];
+}
+
+// Measurement
+
+const gcEntries = [];
+const gcObserver = new PerformanceObserver(list => gcEntries.push(...list.getEntries()));
+gcObserver.observe({ entryTypes: ['gc'] });
+
+const collect = typeof global.gc === 'function' ? global.gc : null;
+
+// GC entries are delivered asynchronously
+const settle = () => new Promise(resolve => setTimeout(resolve, 10));
+
+function gcTimeBetween(start, end) {
+  let time = 0;
+  let count = 0;
+  for (const entry of gcEntries) {
+    if (entry.startTime >= start && entry.startTime < end) {
+      time += entry.duration;
+      count++;
+    }
+  }
+  return { time, count };
+}
+
+// Heap still held by the result of fn() after a full collection
+function retainedHeap(fn) {
+  if (collect === null) return null;
+  collect();
+  const before = process.memoryUsage().heapUsed;
+  const result = fn();
+  collect();
+  const after = process.memoryUsage().heapUsed;
+  // Use the result after collecting so it stays reachable until then
+  return result === undefined ? null : Math.max(0, after - before);
+}
+
+async function measure(name, operation, bytes, fn) {
+  // Warm up, then run until both minTime and 5 iterations have passed
+  fn();
+  collect?.();
+  await settle();
+
+  const times = [];
+  const start = performance.now();
+  while (times.length < 5 || performance.now() - start < minTime) {
+    const t = performance.now();
+    fn();
+    times.push(performance.now() - t);
+  }
+  const end = performance.now();
+  await settle();
+
+  times.sort((a, b) => a - b);
+  const gc = gcTimeBetween(start, end);
+  const total = end - start;
+  const median = times[times.length >> 1];
+  return {
+    document: name,
+    operation,
+    bytes,
+    iterations: times.length,
+    medianMs: round(median),
+    minMs: round(times[0]),
+    meanMs: round(times.reduce((sum, time) => sum + time, 0) / times.length),
+    mbPerSecond: round(bytes / 1e6 / (median / 1000)),
+    retainedBytes: retainedHeap(fn),
+    gcMs: round(gc.time),
+    gcCount: gc.count,
+    gcPercent: round(gc.time / total * 100)
+  };
+}
+
+const round = value => Math.round(value * 100) / 100;
+
+function environment() {
+  let commit = null;
+  try {
+    commit = execSync('git rev-parse --short HEAD', { cwd: here, stdio: ['ignore', 'pipe', 'ignore'] }).toString().trim();
+  } catch {
+    // Not a git checkout
+  }
+  return {
+    date: new Date().toISOString(),
+    commit,
+    node: process.version,
+    v8: process.versions.v8,
+    platform: process.platform,
+    arch: process.arch,
+    cpu: os.cpus()[0]?.model ?? null,
+    exposeGc: collect !== null,
+    quick
+  };
+}
+
+// Main
+
+const results = [];
+for (const { name, text } of documents()) {
+  if (filter && !name.includes(filter)) continue;
+  const bytes = Buffer.from(text);
+  const value = parse(text);
+
+  results.push(await measure(name, 'parse', bytes.length, () => parse(text)));
+  results.push(await measure(name, 'parse(bytes)', bytes.length, () => parse(bytes)));
+  results.push(await measure(name, 'stringify', bytes.length, () => stringify(value)));
+
+  for (const result of results.slice(-3)) {
+    console.log(
+      `${result.document.padEnd(40)} ${result.operation.padEnd(13)} ` +
+      `${String(result.medianMs).padStart(10)} ms ${String(result.mbPerSecond).padStart(8)} MB/s ` +
+      `gc ${String(result.gcPercent).padStart(5)}%`
+    );
+  }
+}
+gcObserver.disconnect();
+
+if (collect === null) {
+  console.log('\nRun with --expose-gc (npm run bench) to measure retained heap');
+}
+
+const report = { environment: environment(), results };
+const out = option('--out') ??
+  path.join(here, 'bench-results', `${report.environment.date.replace(/[:.]/g, '-')}-node${process.versions.node}.json`);
+fs.mkdirSync(path.dirname(out), { recursive: true });
+fs.writeFileSync(out, JSON.stringify(report, null, 2) + '\n');
+console.log(`\nResults written to ${out}`);
+
+const baselineFile = option('--compare');
+if (baselineFile) {
+  const baseline = JSON.parse(fs.readFileSync(baselineFile, 'utf8'));
+  const key = result => `${result.document}\0${result.operation}`;
+  const before = new Map(baseline.results.map(result => [key(result), result]));
+  console.log(`\nCompared with ${baselineFile} (${baseline.environment.node}, ${baseline.environment.commit ?? 'unknown commit'}):`);
+  for (const result of results) {
+    const old = before.get(key(result));
+    if (!old) continue;
+    const change = (result.medianMs / old.medianMs - 1) * 100;
+    console.log(
+      `${result.document.padEnd(40)} ${result.operation.padEnd(13)} ` +
+      `${String(old.medianMs).padStart(10)} -> ${String(result.medianMs).padStart(10)} ms ` +
+      `${change >= 0 ? '+' : ''}${change.toFixed(1)}%`
+    );
+  }
+}
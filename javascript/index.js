@@ -8,240 +8,1578 @@ const NULL_VALUE = '~';
 const EMPTY_STRING = '""';
 const RAW_TEXT = '...';
 
+const TAB_CODE = 0x09;
+const SPACE_CODE = 0x20;
+const HASH_CODE = 0x23;
+const NEWLINE_CODE = 0x0a;
+const CR_CODE = 0x0d;
+
 const TRUTHY_VALUES = new Set(['true', 'yes', 'on'])
 const FALSY_VALUES = new Set(['false', 'no', 'off'])
 
 const ISO_DATE_RE = /^\d{4}-\d{2}(?:-\d{2}(?:T\d{2}:\d{2}(?::\d{2}(?:\.\d+)?)?(?:Z|[+-]\d{2}:\d{2})?)?)?$/
+const INTEGER_RE = /^-?\d+$/
+const FLOAT_RE = /^-?\d+\.\d+$/
+
+export class TAMLError extends Error {
+  constructor(message, line) {
+    super(line !== undefined ? `Line ${line}: ${message}` : message);
+    this.name = 'TAMLError';
+    this.line = line;
+  }
+}
+
+/**
+ * Parse a TAML string into a JavaScript object
+ * @param {string|Uint8Array} text - TAML formatted text, or its UTF-8 bytes
+ * @param {Object} options - Parsing options
+ * @param {boolean} options.strict - Enable strict parsing (default: false)
+ * @param {boolean} options.typeConversion - Convert string values to native types (default: true)
+ * @param {Object} options.schema - Map of dotted key paths to value types (see compileSchema)
+ * @param {Function} options.reviver - Called as reviver.call(holder, key, value) for every
+ *   value, innermost first, as in JSON.parse; its result replaces the value
+ * @returns {Object} Parsed JavaScript object
+ */
+export function parse(text, options = {}){
+  const parser = new Parser(options);
+  if (text instanceof Uint8Array) {
+    parseBytes(parser, text);
+  } else {
+    parseLines(parser, text, 0, text.length, 1);
+  }
+
+  return reviveRoot(parser.finish(), options.reviver);
+}
+
+/**
+ * Parse a TAML string, collecting every error instead of stopping at the
+ * first, in the same single pass
+ * @param {string|Uint8Array} text - TAML formatted text, or its UTF-8 bytes
+ * @param {Object} options - Parsing options, as for parse() (strict and reviver are not used)
+ * @param {boolean} options.positions - Also return where each value is defined (default: false)
+ * @returns {{value: Object, diagnostics: Array, positions: (Map|undefined)}} The
+ *   lenient parse result; the errors, each { line, column, message, severity },
+ *   in document order; and with `positions`, a Map from each object and array
+ *   in the result to { line, column, entries }, where `entries` maps each key
+ *   or index to the { line, column } of its line. Lines and columns are 1-based.
+ */
+export function parseWithDiagnostics(text, options = {}) {
+  const parser = new Parser({ ...options, strict: false });
+  parser.diagnostics = [];
+  if (options.positions) {
+    parser.positions = new Map();
+    parser.locateNode(parser.root.node, 1, 0);
+  }
+
+  if (text instanceof Uint8Array) {
+    // Columns are counted in characters
+    text = new TextDecoder('utf-8', { ignoreBOM: true }).decode(text);
+  }
+  parseLines(parser, text, 0, text.length, 1);
+  const value = parser.finish();
+
+  // Errors in undecided blocks are found when the block is decided
+  const diagnostics = parser.diagnostics.sort((a, b) => a.line - b.line || a.column - b.column);
+  return options.positions ? { value, diagnostics, positions: parser.positions } : { value, diagnostics };
+}
+
+/**
+ * Feed the lines of `text[start, end]` to a parser, the first being
+ * line `lineNum`
+ */
+function parseLines(parser, text, start, end, lineNum) {
+  while (start <= end) {
+    let newline = text.indexOf('\n', start);
+    if (newline === -1 || newline > end) newline = end;
+    parser.line(text, start, newline, lineNum++);
+    start = newline + 1;
+  }
+}
+
+/**
+ * Apply a reviver to a parsed root, as JSON.parse does
+ */
+function reviveRoot(value, reviver) {
+  if (!reviver) return value;
+  const holder = { '': value };
+  revive(holder, '', reviver);
+  return holder[''];
+}
+
+/**
+ * Replace `holder[key]` and everything under it with the reviver's results,
+ * children before their parent. A result of undefined deletes the entry.
+ */
+function revive(holder, key, reviver) {
+  const pending = [{ holder, key, expanded: false }];
+
+  while (pending.length > 0) {
+    const item = pending[pending.length - 1];
+    const value = item.holder[item.key];
+
+    if (!item.expanded && typeof value === 'object' && value !== null && !(value instanceof Date)) {
+      item.expanded = true;
+      const keys = Array.isArray(value) ? value.map((_, index) => String(index)) : Object.keys(value);
+      for (let i = keys.length - 1; i >= 0; i--) {
+        pending.push({ holder: value, key: keys[i], expanded: false });
+      }
+      continue;
+    }
+
+    pending.pop();
+    const result = reviver.call(item.holder, item.key, value);
+    if (result === undefined) {
+      delete item.holder[item.key];
+    } else {
+      item.holder[item.key] = result;
+    }
+  }
+}
+
+/**
+ * Feed the lines of UTF-8 `bytes` to a parser, decoding only keys, values
+ * and raw text rather than the whole document
+ */
+function parseBytes(parser, bytes) {
+  parser.decoder = new SliceDecoder(bytes);
+  let start = 0;
+  let lineNum = 1;
+
+  while (true) {
+    const newline = bytes.indexOf(NEWLINE_CODE, start);
+    const end = newline === -1 ? bytes.length : newline;
+    parser.lineBytes(bytes, start, end, lineNum++);
+    if (newline === -1) break;
+    start = newline + 1;
+  }
+}
+
+// Short ASCII byte ranges (keys, small values) are decoded through a
+// direct-mapped cache of this many strings
+const SLICE_CACHE_SIZE = 1024;
+const SLICE_CACHE_MAX_LENGTH = 32;
+
+/**
+ * Decodes UTF-8 byte ranges of one input, reusing the strings of repeated
+ * short ASCII ranges such as keys
+ */
+class SliceDecoder {
+  constructor(bytes) {
+    this.cache = new Array(SLICE_CACHE_SIZE).fill('');
+    if (typeof Buffer === 'function') {
+      // Buffer view of the same memory, for its faster decoding
+      this.bytes = Buffer.isBuffer(bytes) ? bytes : Buffer.from(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+      this.decoder = null;
+    } else {
+      this.bytes = bytes;
+      // Keep a BOM, as Buffer#toString does
+      this.decoder = new TextDecoder('utf-8', { ignoreBOM: true });
+    }
+  }
+
+  decode(start, end) {
+    const bytes = this.bytes;
+    const length = end - start;
+    if (length > SLICE_CACHE_MAX_LENGTH) return this.decodeRange(start, end);
+
+    let hash = length;
+    for (let pos = start; pos < end; pos++) {
+      const code = bytes[pos];
+      if (code >= 0x80) return this.decodeRange(start, end);
+      hash = (hash * 31 + code) | 0;
+    }
+
+    const slot = hash & (SLICE_CACHE_SIZE - 1);
+    const cached = this.cache[slot];
+    if (cached.length === length) {
+      let pos = 0;
+      while (pos < length && cached.charCodeAt(pos) === bytes[start + pos]) pos++;
+      if (pos === length) return cached;
+    }
+    // Latin-1 decodes ASCII faster than UTF-8
+    const text = this.decoder === null ? this.bytes.toString('latin1', start, end) : this.decodeRange(start, end);
+    this.cache[slot] = text;
+    return text;
+  }
+
+  decodeRange(start, end) {
+    if (this.decoder === null) return this.bytes.toString('utf8', start, end);
+    return this.decoder.decode(this.bytes.subarray(start, end));
+  }
+}
+
+/**
+ * Parse a TAML string lazily. Only the top-level keys are found up front;
+ * the value of a key is parsed the first time it is read, then kept.
+ * The returned object otherwise behaves like the result of parse().
+ * In strict mode, errors are thrown when the key containing them is read.
+ * A reviver is applied to each top-level value as it is parsed; it is not
+ * called for the root object.
+ * @param {string} text - TAML formatted text
+ * @param {Object} options - Parsing options, as for parse()
+ * @returns {Object} Proxy over the parsed top-level object
+ */
+export function parseLazy(text, options = {}) {
+  const sections = indexSections(text, options);
+  const target = {};
+  for (const key of sections.keys()) {
+    target[key] = undefined;
+  }
+
+  const load = key => {
+    const group = sections.get(key);
+    const keys = group.keys.filter(other => sections.get(other) === group);
+    const parser = new Parser(options);
+    for (const range of group.sections) {
+      parseLines(parser, text, range.start, range.end, range.line);
+    }
+    const value = parser.finish();
+    for (const other of keys) {
+      sections.delete(other);
+      target[other] = value[other];
+      if (options.reviver) revive(target, other, options.reviver);
+    }
+  };
+
+  return new Proxy(target, {
+    get(target, key, receiver) {
+      if (sections.has(key)) load(key);
+      return Reflect.get(target, key, receiver);
+    },
+    getOwnPropertyDescriptor(target, key) {
+      if (sections.has(key)) load(key);
+      return Reflect.getOwnPropertyDescriptor(target, key);
+    },
+    set(target, key, value, receiver) {
+      sections.delete(key);
+      return Reflect.set(target, key, value, receiver);
+    },
+    defineProperty(target, key, descriptor) {
+      sections.delete(key);
+      return Reflect.defineProperty(target, key, descriptor);
+    },
+    deleteProperty(target, key) {
+      sections.delete(key);
+      return Reflect.deleteProperty(target, key);
+    }
+  });
+}
+
+/**
+ * Map each top-level key to the group of sections that set it. A section
+ * runs from a key line at indent 0 to the next one; a repeated key has one
+ * section per occurrence. A section can also set other top-level keys with
+ * indented raw text lines while its parent is the root (after a key with a
+ * value, or before the first key), so the keys a section sets share one
+ * group, and their sections are parsed together in document order.
+ */
+function indexSections(text, options) {
+  const scanner = new Parser();
+  const sections = new Map();
+  // Lines before the first key
+  const prefix = { start: 0, end: text.length, line: 1, keys: [] };
+  let section = prefix;
+  // Whether indented lines are parsed against the root
+  let atRoot = true;
+  // Indent of the raw text block being skipped, or -1
+  let rawIndent = -1;
+  let start = 0;
+  let lineNum = 1;
+
+  while (start <= text.length) {
+    let newline = text.indexOf('\n', start);
+    if (newline === -1) newline = text.length;
+    if (rawIndent !== -1 && !isRawLine(text, start, newline, rawIndent)) rawIndent = -1;
+    if (rawIndent === -1 && scanner.scanLine(text, start, newline) && isKeyLine(scanner, text.charCodeAt(start))) {
+      const key = text.slice(scanner.keyStart, scanner.keyEnd);
+      const hasValue = scanner.valueStart !== -1;
+      const raw = hasValue && text.slice(scanner.valueStart, scanner.valueEnd) === RAW_TEXT;
+      if (scanner.indent === 0) {
+        section.end = start - 1;
+        addSection(sections, section);
+        section = { start, end: 0, line: lineNum, keys: [key] };
+        atRoot = hasValue;
+      } else if (raw && atRoot) {
+        section.keys.push(key);
+      }
+      if (raw) rawIndent = scanner.indent + 1;
+    }
+    lineNum++;
+    start = newline + 1;
+  }
+
+  section.end = text.length;
+  addSection(sections, section);
+  if (options.strict) {
+    const parser = new Parser(options);
+    parseLines(parser, text, prefix.start, prefix.end, prefix.line);
+    parser.finish();
+  }
+  return sections;
+}
+
+/**
+ * Add a section to the groups of the keys it sets, merging groups that
+ * now share it
+ */
+function addSection(sections, section) {
+  let group = null;
+  for (const key of section.keys) {
+    const other = sections.get(key);
+    if (other === undefined || other === group) continue;
+    if (group === null) {
+      group = other;
+      continue;
+    }
+    for (const otherKey of other.keys) {
+      group.keys.push(otherKey);
+      sections.set(otherKey, group);
+    }
+    group.sections.push(...other.sections);
+    group.sections.sort((a, b) => a.start - b.start);
+  }
+  if (group === null) {
+    if (section.keys.length === 0) return;
+    group = { keys: [], sections: [] };
+  }
+
+  group.sections.push(section);
+  for (const key of section.keys) {
+    if (sections.has(key)) continue;
+    group.keys.push(key);
+    sections.set(key, group);
+  }
+}
+
+/**
+ * Whether the line `text[start, end)` belongs to a raw text block whose
+ * lines are indented by at least `baseIndent` tabs (see Parser#collectRaw)
+ */
+function isRawLine(text, start, end, baseIndent) {
+  let pos = start;
+  while (pos < end && isWhitespace(text.charCodeAt(pos))) pos++;
+  if (pos === end) return true;
+  pos = start;
+  while (pos < end && text.charCodeAt(pos) === TAB_CODE) pos++;
+  return pos - start >= baseIndent;
+}
+
+/**
+ * Parse TAML from a stream of text chunks
+ * @param {AsyncIterable<string|Uint8Array>} readable - Node.js Readable or any async iterable of chunks
+ * @param {Object} options - Parsing options, as for parse()
+ * @returns {Promise<Object>} Parsed JavaScript object
+ */
+export async function parseStream(readable, options = {}) {
+  const parser = new Parser(options);
+  const lines = new LineFeeder(parser);
+
+  for await (const chunk of readable) {
+    lines.write(chunk);
+  }
+
+  return reviveRoot(lines.end(), options.reviver);
+}
+
+/**
+ * Iterate over the objects of a repeated bare key as each one completes.
+ * Yielded objects are not kept, so memory stays bounded by the size of a
+ * record rather than the whole document.
+ * @param {AsyncIterable<string|Uint8Array>} readable - Node.js Readable or any async iterable of chunks
+ * @param {string} key - Repeated bare key of the records (e.g. `user` in `users`/`user`/`user`)
+ * @param {Object} options - Parsing options, as for parse()
+ * @returns {AsyncGenerator<Object>} Record objects in document order
+ */
+export async function* iterateRecords(readable, key, options = {}) {
+  const parser = new Parser(options);
+  parser.collectRecords(key);
+  const lines = new LineFeeder(parser);
+
+  for await (const chunk of readable) {
+    lines.write(chunk);
+    yield* parser.takeRecords();
+  }
+
+  lines.end();
+  yield* parser.takeRecords();
+}
+
+/**
+ * Parse a large TAML document on a pool of worker threads.
+ * The input is split into sections at key lines, the sections are parsed
+ * in parallel and their top-level keys merged in document order. Sections
+ * start at indent-0 keys, or, when one key's block is larger than a
+ * section, at the records (repeated bare keys) of its collection. A bare
+ * key repeated across sections makes a collection as it does within one.
+ * Documents whose sections can't be merged this way (a bare key following
+ * a list, sections that disagree on the kind of a block they share, or any
+ * strict-mode error) are parsed again whole in a single worker, so the
+ * result is always that of parse().
+ * @param {string|Uint8Array} input - TAML text, or its UTF-8 bytes. Bytes
+ *   backed by a SharedArrayBuffer are shared with the workers without copying.
+ * @param {Object} options - Parsing options, as for parse(). Schema converters
+ *   must be type names rather than functions, which can't be sent to workers.
+ * @param {number} options.workers - Number of worker threads (default: number of CPUs)
+ * @param {number} options.partitionSize - Target section size in bytes (default: 8 MiB)
+ * @returns {Promise<Object>} Parsed JavaScript object
+ */
+export async function parseParallel(input, options = {}) {
+  const { Worker } = await import('worker_threads');
+  const { cpus } = await import('os');
+  const { workers = cpus().length, partitionSize = 8 * 1024 * 1024, reviver, ...parseOptions } = options;
+  if (!Number.isInteger(workers) || workers < 1) {
+    throw new RangeError(`workers must be a positive integer, got ${workers}`);
+  }
+  if (!(partitionSize > 0)) {
+    throw new RangeError(`partitionSize must be positive, got ${partitionSize}`);
+  }
+  const bytes = sharedBytes(input);
+  const sections = partitionBytes(bytes, partitionSize);
+  const results = new Array(sections.length);
+  const pool = [];
+
+  const run = (worker, section) => new Promise((resolve, reject) => {
+    const onMessage = message => {
+      worker.removeListener('error', onError);
+      if (message.error) {
+        reject(Object.assign(new TAMLError(message.error.message), { line: message.error.line }));
+      } else {
+        resolve(message.result);
+      }
+    };
+    const onError = error => {
+      worker.removeListener('message', onMessage);
+      reject(error);
+    };
+    worker.once('message', onMessage);
+    worker.once('error', onError);
+    worker.postMessage(section);
+  });
+  const whole = { start: 0, end: bytes.length, header: null };
+
+  try {
+    for (let i = Math.min(workers, sections.length); i > 0; i--) {
+      pool.push(new Worker(new URL('./parse-worker.js', import.meta.url), {
+        workerData: { buffer: bytes.buffer, byteOffset: bytes.byteOffset, length: bytes.length, options: parseOptions }
+      }));
+    }
+
+    if (sections.length === 1) {
+      return reviveRoot((await run(pool[0], whole)).value, reviver);
+    }
+
+    let next = 0;
+    let failed = false;
+    await Promise.all(pool.map(async worker => {
+      while (next < sections.length && !failed) {
+        const index = next++;
+        try {
+          results[index] = await run(worker, sections[index]);
+        } catch (error) {
+          if (!(error instanceof TAMLError)) throw error;
+          failed = true;
+        }
+      }
+    }));
+
+    const merged = failed ? null : mergeSections(sections, results);
+    if (merged !== null) return reviveRoot(merged, reviver);
+
+    // Errors, and blocks the sections disagree on, depend on the whole document
+    return reviveRoot((await run(pool[0], whole)).value, reviver);
+  } finally {
+    for (const worker of pool) {
+      worker.terminate();
+    }
+  }
+}
+
+/**
+ * UTF-8 bytes of the input in shared memory
+ */
+function sharedBytes(input) {
+  if (typeof input !== 'string' && input.buffer instanceof SharedArrayBuffer) {
+    return input;
+  }
+  const length = typeof input === 'string' ? Buffer.byteLength(input) : input.length;
+  const bytes = Buffer.from(new SharedArrayBuffer(length));
+  if (typeof input === 'string') {
+    bytes.write(input);
+  } else {
+    bytes.set(input);
+  }
+  return bytes;
+}
+
+/**
+ * Split the input into sections of about `partitionSize` bytes, each
+ * starting at a line parse() accepts as a key: an indent-0 key, or a
+ * record of a collection one tab in, that is, a bare key with children
+ * whose key the next such line repeats. A section starting at a record
+ * continues the block of the last indent-0 key, whose line is its `header`.
+ * @returns {Array<{start: number, end: number, header: ({start: number, end: number, key: string}|null)}>}
+ */
+function partitionBytes(bytes, partitionSize) {
+  const buffer = Buffer.from(bytes.buffer, bytes.byteOffset, bytes.length);
+  const scanner = new Parser();
+  const decoder = new SliceDecoder(buffer);
+  const sections = [];
+  let start = 0;
+  let header = null;
+  let target = partitionSize;
+
+  while (target < buffer.length) {
+    let split = -1;
+    let splitHeader = null;
+    // Last record, and a bare key one tab in until the line after it shows
+    // whether it has children
+    let record = -1;
+    let recordKey = null;
+    let bare = -1;
+    let bareKey = null;
+    // Header of the block holding the records, once needed
+    let root;
+
+    let lineStart = buffer.indexOf(NEWLINE_CODE, target - 1) + 1;
+    while (lineStart > 0 && lineStart < buffer.length) {
+      let lineEnd = buffer.indexOf(NEWLINE_CODE, lineStart);
+      if (lineEnd === -1) lineEnd = buffer.length;
+      if (!scanner.scanBytes(buffer, lineStart, lineEnd)) {
+        lineStart = lineEnd + 1;
+        continue;
+      }
+      const indent = scanner.indent;
+
+      if (bare !== -1) {
+        if (indent > 1 && bareKey === recordKey) {
+          if (root === undefined) {
+            const line = rootKeyLine(decoder, buffer, start, record);
+            root = line === undefined ? header : line;
+          }
+          if (root !== null) {
+            split = record;
+            splitHeader = root;
+            break;
+          }
+        }
+        record = indent > 1 ? bare : -1;
+        recordKey = indent > 1 ? bareKey : null;
+        bare = -1;
+      }
+
+      if (indent === 0) {
+        if (isKeyLine(scanner, buffer[lineStart])) {
+          split = lineStart;
+          break;
+        }
+        // Any other line at indent 0 decides the kind of the block before it
+        root = null;
+      } else if (indent === 1) {
+        if (isKeyLine(scanner, buffer[lineStart]) && scanner.valueStart === -1) {
+          bare = lineStart;
+          bareKey = decoder.decode(scanner.keyStart, scanner.keyEnd);
+        } else {
+          record = -1;
+          recordKey = null;
+        }
+      }
+      lineStart = lineEnd + 1;
+    }
+
+    if (split === -1) break;
+    sections.push({ start, end: split, header });
+    start = split;
+    header = splitHeader;
+    target = split + partitionSize;
+  }
+
+  sections.push({ start, end: buffer.length, header });
+  return sections;
+}
+
+/**
+ * The line of the indent-0 bare key whose block holds `to`, looking back
+ * to `from`. Returns null if the last line at indent 0 is anything else,
+ * and undefined if there is none.
+ */
+function rootKeyLine(decoder, buffer, from, to) {
+  const scanner = new Parser();
+  let end = to - 1;
+  while (end >= from) {
+    const start = end > 0 ? buffer.lastIndexOf(NEWLINE_CODE, end - 1) + 1 : 0;
+    if (buffer[start] !== TAB_CODE && scanner.scanBytes(buffer, start, end)) {
+      if (!isKeyLine(scanner, buffer[start]) || scanner.valueStart !== -1) return null;
+      return { start, end, key: decoder.decode(scanner.keyStart, scanner.keyEnd) };
+    }
+    end = start - 1;
+  }
+  return undefined;
+}
+
+/**
+ * Whether parse() takes the line just scanned by `scanner`, whose first
+ * character or byte is `first`, as a key rather than reporting an error
+ */
+function isKeyLine(scanner, first) {
+  if (first === SPACE_CODE || scanner.keyEnd === scanner.keyStart) return false;
+  return scanner.valueStart === -1 || !scanner.valueHasTab;
+}
+
+/**
+ * Parse one section of a document for parseParallel(), after its header
+ * line if it continues a block. Returns the root object and how each of
+ * its keys was set (see Parser#countRootKey), for mergeSections().
+ * @internal Used by parse-worker.js
+ */
+export function parseSection(bytes, start, end, header, options) {
+  const parser = new Parser(options);
+  parser.decoder = new SliceDecoder(bytes);
+  parser.rootKeys = new Map();
+  let lineNum = 1;
+
+  if (header !== null) {
+    parser.lineBytes(bytes, header.start, header.end, lineNum++);
+    // The records before the section have already made the block a collection
+    parser.decideCollection();
+  }
+  while (true) {
+    const newline = bytes.indexOf(NEWLINE_CODE, start);
+    if (newline === -1 || newline >= end) {
+      parser.lineBytes(bytes, start, end, lineNum);
+      break;
+    }
+    parser.lineBytes(bytes, start, newline, lineNum++);
+    start = newline + 1;
+  }
+  return { value: parser.finish(), keys: parser.rootKeys };
+}
+
+/**
+ * Combine the sections' top-level keys as parse() would have set them
+ * reading the sections in order, or return null when a section's result
+ * depends on the lines before it in a way its own result can't show
+ */
+function mergeSections(sections, results) {
+  const merged = {};
+  // Records of the collection whose block the next section continues
+  let open = null;
+
+  for (let i = 0; i < results.length; i++) {
+    const { value, keys } = results[i];
+    const header = sections[i].header;
+
+    for (const key of Object.keys(value)) {
+      const current = value[key];
+      const { bare, count, value: hasValue } = keys.get(key);
+      const previous = merged[key];
+
+      if (header !== null && key === header.key) {
+        // The header's own line is the only one that sets the key, and the
+        // section starts with repeated records, which decide a collection
+        if (open === null || count !== 1 || !Array.isArray(current) || !isRecords(current)) return null;
+        for (const record of current) open.push(record);
+      } else if (!Object.prototype.hasOwnProperty.call(merged, key) || !bare || hasValue ||
+          typeof previous !== 'object' || previous === null) {
+        merged[key] = current;
+      } else {
+        // A bare key after an object or array adds an object to it, and the
+        // section has then parsed each of its lines as one such object
+        const records = count === 1 ? [current] : current;
+        if (!Array.isArray(records) || records.length !== count || !isRecords(records)) return null;
+        const list = Array.isArray(previous) ? previous : (merged[key] = [previous]);
+        for (const record of records) list.push(record);
+      }
+    }
+
+    const following = sections[i + 1];
+    if (following !== undefined && following.header !== null && following.header !== header) {
+      const key = following.header.key;
+      open = null;
+      if (keys.get(key)?.count === 1 && merged[key] === value[key]) {
+        // Before its first repeated record, a collection's block parses as
+        // an object of records
+        const records = Array.isArray(value[key]) ? value[key] : Object.values(value[key]);
+        if (isRecords(records)) open = merged[key] = records;
+      }
+    }
+  }
+  return merged;
+}
+
+/**
+ * Whether every item of `records` is an object, as in a collection
+ */
+function isRecords(records) {
+  for (const item of records) {
+    if (typeof item !== 'object' || item === null || Array.isArray(item) || item instanceof Date) return false;
+  }
+  return true;
+}
+
+/**
+ * Splits streamed chunks into lines for a Parser, carrying a partial last
+ * line over to the next chunk
+ */
+class LineFeeder {
+  constructor(parser) {
+    this.parser = parser;
+    this.carry = '';
+    this.lineNum = 1;
+    this.decoder = null;
+  }
+
+  write(chunk) {
+    if (typeof chunk !== 'string') {
+      // Keep a BOM, as Buffer#toString does for parse()
+      if (this.decoder === null) this.decoder = new TextDecoder('utf-8', { ignoreBOM: true });
+      chunk = this.decoder.decode(chunk, { stream: true });
+    }
+
+    let start = 0;
+    let newline = chunk.indexOf('\n');
+    if (newline === -1) {
+      this.carry += chunk;
+      return;
+    }
+
+    if (this.carry !== '') {
+      const line = this.carry + chunk.slice(0, newline);
+      this.carry = '';
+      this.parser.line(line, 0, line.length, this.lineNum++);
+      start = newline + 1;
+      newline = chunk.indexOf('\n', start);
+    }
+
+    while (newline !== -1) {
+      this.parser.line(chunk, start, newline, this.lineNum++);
+      start = newline + 1;
+      newline = chunk.indexOf('\n', start);
+    }
+    this.carry = chunk.slice(start);
+  }
+
+  end() {
+    if (this.decoder !== null) this.carry += this.decoder.decode();
+    this.parser.line(this.carry, 0, this.carry.length, this.lineNum);
+    this.carry = '';
+    return this.parser.finish();
+  }
+}
+
+// Container kinds, decided from the children of a bare key
+const KIND_OBJECT = 1;
+const KIND_LIST = 2;
+const KIND_COLLECTION = 3;
+
+// How a bare key is placed into its parent's container
+const ROLE_OWN = 1;     // its own kind decides the container
+const ROLE_OBJECT = 2;  // collection item or repeated key: always a plain object
+const ROLE_ITEM = 3;    // list item: only the key is kept
+
+// Children recorded while their parent's kind is still undecided
+const ENTRY_VALUE = 1;
+const ENTRY_RAW = 2;
+const ENTRY_BAD_INDENT = 3;
+
+/**
+ * A bare key on the parse stack.
+ *
+ * Whether a bare key holds an object, a list or a collection of objects
+ * depends on its direct children, so the kind is worked out as they stream
+ * past: a repeated bare key with children settles it as a collection right
+ * away, anything else is settled when the child block ends. Children seen
+ * before then are recorded in `entries` and replayed into the container.
+ */
+class Frame {
+  constructor(level, key, line) {
+    this.level = level;
+    this.key = key;
+    this.line = line;
+    this.kind = 0;
+    this.role = 0;
+    this.node = null;
+    this.parentNode = null;
+    this.entries = [];
+    this.scanning = true;
+    this.hasListItems = false;
+    this.hasKeyValuePairs = false;
+    this.bareKeyNames = null;
+    this.closed = false;
+    this.record = false;
+    this.inRecord = false;
+    // Compiled schema node for this key path, or null
+    this.schema = null;
+    // Number of recorded entries replayed so far
+    this.replayed = 0;
+  }
+}
+
+/**
+ * Single-pass TAML parser. Feed lines in document order with `line()`,
+ * then call `finish()` for the parsed root object.
+ */
+class Parser {
+  constructor(options = {}) {
+    const { strict = false, typeConversion = true, schema = null } = options;
+    this.strict = strict;
+    this.typeConversion = typeConversion;
+
+    const root = new Frame(-1, null, 0);
+    root.kind = KIND_OBJECT;
+    root.role = ROLE_OWN;
+    root.node = {};
+    root.entries = null;
+    root.scanning = false;
+    root.schema = schema === null ? null : compileSchema(schema);
+    this.root = root;
+
+    this.stack = [root];
+    // Bare keys whose child block is still open, innermost last
+    this.scans = [];
+    // Last direct child bare key, until the next line shows whether it has children
+    this.bareParent = null;
+    this.bareKey = null;
+    this.bareLevel = 0;
+    // Ranges of the line being parsed, from scanLine()
+    this.indent = 0;
+    this.keyStart = 0;
+    this.keyEnd = 0;
+    this.valueStart = -1;
+    this.valueEnd = -1;
+    this.valueHasTab = false;
+    // Raw text block being collected
+    this.raw = null;
+    // Frames whose recorded children are being replayed
+    this.replays = [];
+    this.replaying = false;
+    // Repeated bare key whose objects are handed out instead of stored
+    this.recordKey = null;
+    this.records = null;
+    this.recordLines = null;
+    this.firstError = null;
+    // Every error, for parseWithDiagnostics()
+    this.diagnostics = null;
+    // Container → { line, column, entries } when positions are tracked
+    this.positions = null;
+    this.lineStart = 0;
+    this.valueTab = -1;
+    // Decodes byte ranges for lineBytes()
+    this.decoder = null;
+    // How each top-level key was set, when parsing a section for parseParallel()
+    this.rootKeys = null;
+  }
+
+  /**
+   * Hand each completed object of repeated bare key `key` to `records`
+   * instead of keeping it in the tree
+   */
+  collectRecords(key) {
+    this.recordKey = key;
+    this.records = [];
+    this.recordLines = new WeakMap();
+  }
+
+  /**
+   * Count a line that sets top-level key `key`: whether the first such
+   * line was a bare key, how many there were and whether any had a value
+   */
+  countRootKey(key, bare) {
+    const entry = this.rootKeys.get(key);
+    if (entry === undefined) {
+      this.rootKeys.set(key, { bare, count: 1, value: !bare });
+    } else {
+      entry.count++;
+      if (!bare) entry.value = true;
+    }
+  }
+
+  /**
+   * Take the records completed so far, in document order
+   */
+  takeRecords() {
+    const records = this.records;
+    this.records = [];
+    if (records.length > 1) records.sort((a, b) => a.line - b.line);
+    return records.map(record => record.value);
+  }
+
+  /**
+   * Parse the line `src[start, end)`
+   */
+  line(src, start, end, lineNum) {
+    if (this.raw !== null) {
+      if (this.collectRaw(src, start, end)) return;
+      this.endRaw();
+    }
+
+    if (!this.scanLine(src, start, end)) return;
+    this.lineStart = start;
+
+    const key = src.slice(this.keyStart, this.keyEnd);
+    const text = this.valueStart === -1 ? null : src.slice(this.valueStart, this.valueEnd);
+    this.entry(key, text, src.charCodeAt(start) === SPACE_CODE, lineNum);
+  }
+
+  /**
+   * Parse the line `bytes[start, end)` of UTF-8 input, decoding only the
+   * key and value
+   */
+  lineBytes(bytes, start, end, lineNum) {
+    if (this.raw !== null) {
+      if (this.collectRawBytes(bytes, start, end)) return;
+      this.endRaw();
+    }
+
+    if (!this.scanBytes(bytes, start, end)) return;
+    this.lineStart = start;
+
+    const key = this.decoder.decode(this.keyStart, this.keyEnd);
+    const text = this.valueStart === -1 ? null : this.decoder.decode(this.valueStart, this.valueEnd);
+    this.entry(key, text, bytes[start] === SPACE_CODE, lineNum);
+  }
+
+  entry(key, text, spaceIndent, lineNum) {
+    this.scan(key);
+    this.parseLine(key, text, spaceIndent, lineNum);
+
+    // Errors in undecided containers surface on replay, so strict mode
+    // throws once nothing earlier can still report one
+    if (this.firstError !== null && this.strict && this.settled()) {
+      throw this.firstError;
+    }
+  }
+
+  /**
+   * Single forward scan of a line into indent, key range and value range
+   * (`valueStart` is -1 for bare keys). Returns false for blank lines and
+   * comments. Trimming follows String.prototype.trim.
+   */
+  scanLine(src, start, end) {
+    let pos = start;
+    while (pos < end && src.charCodeAt(pos) === TAB_CODE) pos++;
+    this.indent = pos - start;
+
+    let first = -1;
+    let last = -1;
+    for (; pos < end; pos++) {
+      const code = src.charCodeAt(pos);
+      if (code === TAB_CODE) break;
+      if (!isWhitespace(code)) {
+        if (first === -1) first = pos;
+        last = pos;
+      }
+    }
+
+    if (pos === end) {
+      // Bare key
+      if (first === -1) return false;
+      if (src.charCodeAt(first) === HASH_CODE) return false;
+      this.keyStart = first;
+      this.keyEnd = last + 1;
+      this.valueStart = -1;
+      return true;
+    }
+
+    this.keyStart = start + this.indent;
+    this.keyEnd = pos;
+
+    // Skip separator tabs, then find the trimmed end and any tab in the value
+    pos++;
+    while (pos < end && src.charCodeAt(pos) === TAB_CODE) pos++;
+    const valueStart = pos;
+    let valueLast = -1;
+    let valueTab = -1;
+    for (; pos < end; pos++) {
+      const code = src.charCodeAt(pos);
+      if (code === TAB_CODE) {
+        if (valueTab === -1) valueTab = pos;
+      } else if (!isWhitespace(code)) {
+        if (first === -1) first = pos;
+        valueLast = pos;
+      }
+    }
+
+    if (first === -1) return false;
+    if (src.charCodeAt(first) === HASH_CODE) return false;
+    this.valueStart = valueStart;
+    this.valueEnd = valueLast === -1 ? valueStart : valueLast + 1;
+    this.valueTab = valueTab;
+    this.valueHasTab = valueTab !== -1 && valueTab < this.valueEnd;
+    return true;
+  }
+
+  /**
+   * scanLine() over UTF-8 bytes
+   */
+  scanBytes(bytes, start, end) {
+    let pos = start;
+    while (pos < end && bytes[pos] === TAB_CODE) pos++;
+    this.indent = pos - start;
+
+    let first = -1;
+    let last = -1;
+    while (pos < end) {
+      const code = bytes[pos];
+      if (code === TAB_CODE) break;
+      const whitespace = code < 0x80 ? (isWhitespace(code) ? 1 : 0) : whitespaceBytes(bytes, pos, end);
+      if (whitespace === 0) {
+        if (first === -1) first = pos;
+        last = pos++;
+      } else {
+        pos += whitespace;
+      }
+    }
+
+    if (pos === end) {
+      // Bare key
+      if (first === -1) return false;
+      if (bytes[first] === HASH_CODE) return false;
+      this.keyStart = first;
+      this.keyEnd = last + 1;
+      this.valueStart = -1;
+      return true;
+    }
+
+    this.keyStart = start + this.indent;
+    this.keyEnd = pos;
+
+    // Skip separator tabs, then find the trimmed end and any tab in the value
+    pos++;
+    while (pos < end && bytes[pos] === TAB_CODE) pos++;
+    const valueStart = pos;
+    let valueLast = -1;
+    let valueTab = -1;
+    while (pos < end) {
+      const code = bytes[pos];
+      if (code === TAB_CODE) {
+        if (valueTab === -1) valueTab = pos;
+        pos++;
+        continue;
+      }
+      const whitespace = code < 0x80 ? (isWhitespace(code) ? 1 : 0) : whitespaceBytes(bytes, pos, end);
+      if (whitespace === 0) {
+        if (first === -1) first = pos;
+        valueLast = pos++;
+      } else {
+        pos += whitespace;
+      }
+    }
+
+    if (first === -1) return false;
+    if (bytes[first] === HASH_CODE) return false;
+    this.valueStart = valueStart;
+    this.valueEnd = valueLast === -1 ? valueStart : valueLast + 1;
+    this.valueTab = valueTab;
+    this.valueHasTab = valueTab !== -1 && valueTab < this.valueEnd;
+    return true;
+  }
+
+  finish() {
+    if (this.raw !== null) this.endRaw();
+    if (this.bareParent !== null) this.countBare(false);
+    while (this.scans.length > 0) {
+      this.endScan(this.scans.pop());
+    }
+    this.popTo(0);
+    if (this.firstError !== null && this.strict) {
+      throw this.firstError;
+    }
+    return this.root.node;
+  }
+
+  /**
+   * Record the line as a direct child of the innermost open bare key, and
+   * close the child blocks it ends
+   */
+  scan(key) {
+    const indent = this.indent;
+    if (this.bareParent !== null) this.countBare(indent > this.bareLevel);
+
+    const scans = this.scans;
+    while (scans.length > 0 && scans[scans.length - 1].level >= indent) {
+      this.endScan(scans.pop());
+    }
+
+    const parent = scans.length > 0 ? scans[scans.length - 1] : null;
+    if (parent === null || !parent.scanning || parent.level !== indent - 1) return;
+
+    if (this.valueStart !== -1) {
+      parent.hasKeyValuePairs = true;
+    } else {
+      this.bareParent = parent;
+      this.bareKey = key;
+      this.bareLevel = indent;
+    }
+  }
+
+  /**
+   * Make the innermost open block a collection, as a repeated bare key
+   * with children does
+   */
+  decideCollection() {
+    const frame = this.top();
+    frame.scanning = false;
+    this.setKind(frame, KIND_COLLECTION);
+  }
+
+  countBare(hasChildren) {
+    const parent = this.bareParent;
+    const key = this.bareKey;
+    this.bareParent = null;
+    this.bareKey = null;
+    if (!parent.scanning) return;
+
+    if (!hasChildren) {
+      parent.hasListItems = true;
+      return;
+    }
+    if (parent.bareKeyNames === null) {
+      parent.bareKeyNames = new Set();
+    } else if (parent.bareKeyNames.has(key)) {
+      // Duplicate bare keys make a collection of objects
+      parent.scanning = false;
+      this.setKind(parent, KIND_COLLECTION);
+      return;
+    }
+    parent.bareKeyNames.add(key);
+  }
+
+  endScan(frame) {
+    if (!frame.scanning) return;
+    frame.scanning = false;
+    this.setKind(frame, frame.hasListItems && !frame.hasKeyValuePairs ? KIND_LIST : KIND_OBJECT);
+  }
+
+  setKind(frame, kind) {
+    frame.kind = kind;
+    frame.bareKeyNames = null;
+    if (frame.role === ROLE_OWN && frame.node === null) {
+      this.ownNode(frame);
+    }
+  }
+
+  parseLine(key, text, spaceIndent, lineNum) {
+    if (spaceIndent) {
+      this.error('Indentation must use tabs, not spaces', lineNum);
+      return;
+    }
+
+    const level = this.indent;
+    const hasValue = text !== null;
+
+    if (!key) {
+      this.error('Line has no key', lineNum, level + 1);
+      return;
+    }
+
+    if (hasValue && this.valueHasTab) {
+      this.error('Value contains invalid tab character', lineNum, this.valueTab - this.lineStart + 1);
+      return;
+    }
+
+    // Raw text blocks take the following lines before being stored
+    if (text === RAW_TEXT) {
+      this.popTo(level);
+      this.raw = { frame: this.top(), key, baseIndent: level + 1, lines: [], line: lineNum };
+      return;
+    }
+
+    this.popTo(level);
+    const parent = this.top();
+
+    if (level > parent.level + 1) {
+      this.badIndent(parent, level, lineNum);
+      return;
+    }
+
+    const schema = parent.schema === null ? null : schemaChild(parent.schema, key);
+    const value = hasValue ? this.convert(schema, text, lineNum) : null;
+
+    if (parent.node === null) {
+      // Parent kind not known yet - record the child for replay
+      if (hasValue) {
+        parent.entries.push({ type: ENTRY_VALUE, key, value, level, line: lineNum });
+      } else {
+        const frame = new Frame(level, key, lineNum);
+        frame.inRecord = parent.inRecord;
+        frame.schema = schema;
+        parent.entries.push(frame);
+        this.stack.push(frame);
+        this.scans.push(frame);
+      }
+      return;
+    }
+
+    if (this.rootKeys !== null && parent === this.root) this.countRootKey(key, !hasValue);
+    if (hasValue) {
+      this.setValue(parent, key, value, lineNum, level);
+      return;
+    }
+
+    const frame = new Frame(level, key, lineNum);
+    frame.schema = schema;
+    this.place(parent, frame);
+    if (frame.role !== ROLE_ITEM) {
+      this.stack.push(frame);
+      if (frame.scanning) this.scans.push(frame);
+    }
+  }
+
+  /**
+   * Value of the text after a key, using the key path's schema type if it
+   * has one and type inference otherwise
+   */
+  convert(schema, text, lineNum) {
+    if (text === NULL_VALUE) return null;
+    if (text === EMPTY_STRING) return '';
+
+    if (schema !== null && schema.convert !== null) {
+      const value = schema.convert(text);
+      if (value !== undefined) return value;
+      this.error(`Value "${text}" is not a valid ${schema.type}`, lineNum, this.valueStart - this.lineStart + 1);
+      return text;
+    }
+
+    return text !== '' && this.typeConversion ? convertType(text) : text;
+  }
+
+  collectRaw(src, start, end) {
+    const raw = this.raw;
+    let pos = start;
+    while (pos < end && isWhitespace(src.charCodeAt(pos))) pos++;
+    // Empty lines within raw text are preserved
+    if (pos === end) {
+      raw.lines.push('');
+      return true;
+    }
+    pos = start;
+    while (pos < end && src.charCodeAt(pos) === TAB_CODE) pos++;
+    if (pos - start < raw.baseIndent) return false;
+    // Strip structural indentation, preserve additional tabs
+    raw.lines.push(src.slice(start + raw.baseIndent, end));
+    return true;
+  }
+
+  collectRawBytes(bytes, start, end) {
+    const raw = this.raw;
+    let pos = start;
+    let whitespace;
+    while (pos < end && (whitespace = whitespaceBytes(bytes, pos, end)) !== 0) pos += whitespace;
+    // Empty lines within raw text are preserved
+    if (pos === end) {
+      raw.lines.push('');
+      return true;
+    }
+    pos = start;
+    while (pos < end && bytes[pos] === TAB_CODE) pos++;
+    if (pos - start < raw.baseIndent) return false;
+    // Strip structural indentation, preserve additional tabs
+    raw.lines.push(this.decoder.decode(start + raw.baseIndent, end));
+    return true;
+  }
+
+  endRaw() {
+    const { frame, key, lines, line, baseIndent } = this.raw;
+    this.raw = null;
+    // Trim trailing empty lines
+    while (lines.length > 0 && lines[lines.length - 1] === '') {
+      lines.pop();
+    }
+    const value = lines.join('\n');
+    if (frame.node === null) {
+      frame.entries.push({ type: ENTRY_RAW, key, value, level: baseIndent - 1, line });
+    } else {
+      if (this.rootKeys !== null && frame === this.root) this.countRootKey(key, false);
+      this.setRaw(frame, key, value, line, baseIndent - 1);
+    }
+  }
+
+  top() {
+    return this.stack[this.stack.length - 1];
+  }
+
+  popTo(level) {
+    const stack = this.stack;
+    while (stack.length > 1 && stack[stack.length - 1].level >= level) {
+      const frame = stack.pop();
+      frame.closed = true;
+      if (frame.record) this.addRecord(frame.node, frame.line);
+    }
+  }
 
-export class TAMLError extends Error {
-  constructor(message, line) {
-    super(line !== undefined ? `Line ${line}: ${message}` : message);
-    this.name = 'TAMLError';
-    this.line = line;
+  addRecord(value, line) {
+    this.records.push({ value, line });
   }
-}
 
-/**
- * Parse a TAML string into a JavaScript object
- * @param {string} text - TAML formatted text
- * @param {Object} options - Parsing options
- * @param {boolean} options.strict - Enable strict parsing (default: false)
- * @param {boolean} options.typeConversion - Convert string values to native types (default: true)
- * @returns {Object} Parsed JavaScript object
- */
-export function parse(text, options = {}){
-  const { strict = false, typeConversion = true } = options;
-  
-  const lines = text.split('\n');
-  const root = {};
-  const stack = [{ level: -1, node: root }];
-  
-  for (let i = 0; i < lines.length; i++) {
-    const line = lines[i];
-    const lineNum = i + 1;
-    
-    if (line.trim() === '') continue;
-    if (line.trimStart().startsWith('#')) continue;
-    
-    if (line.match(/^[ \t]+/) && line.match(/^ /)) {
-      if (strict) {
-        throw new TAMLError('Indentation must use tabs, not spaces', lineNum);
-      }
-      continue;
+  settled() {
+    const stack = this.stack;
+    for (let i = stack.length - 1; i > 0; i--) {
+      if (stack[i].node === null) return false;
     }
-    
-    const indentMatch = line.match(/^(\t*)/);
-    const level = indentMatch ? indentMatch[1].length : 0;
-    const content = line.substring(level);
-    
-    if (content.trim() === '') continue;
-    
-    const tabIndex = content.indexOf(TAB);
-    const hasValue = tabIndex !== -1;
-    const key = hasValue ? content.substring(0, tabIndex) : content.trim();
-    const rawValue = hasValue ? content.substring(tabIndex + 1).replace(/^\t+/, '').trimEnd() : null;
-    
-    if (!key) {
-      if (strict) throw new TAMLError('Line has no key', lineNum);
-      continue;
+    return true;
+  }
+
+  error(message, lineNum, column = 1) {
+    if (this.firstError === null || lineNum < this.firstError.line) {
+      this.firstError = new TAMLError(message, lineNum);
     }
-    
-    if (rawValue && rawValue !== RAW_TEXT && rawValue.includes(TAB)) {
-      if (strict) throw new TAMLError('Value contains invalid tab character', lineNum);
-      continue;
+    if (this.diagnostics !== null) {
+      this.diagnostics.push({ line: lineNum, column, message, severity: 'error' });
     }
-    
-    // Handle raw text blocks
-    if (rawValue === RAW_TEXT) {
-      const baseIndent = level + 1;
-      const rawLines = [];
-      let j = i + 1;
-      while (j < lines.length) {
-        const rawLine = lines[j];
-        // Empty lines within raw text are preserved
-        if (rawLine.trim() === '') {
-          rawLines.push('');
-          j++;
-          continue;
-        }
-        const rawIndent = (rawLine.match(/^(\t*)/) || ['', ''])[1].length;
-        if (rawIndent < baseIndent) break;
-        // Strip structural indentation, preserve additional tabs
-        rawLines.push(rawLine.substring(baseIndent));
-        j++;
-      }
-      // Trim trailing empty lines
-      while (rawLines.length > 0 && rawLines[rawLines.length - 1] === '') {
-        rawLines.pop();
-      }
-      const value = rawLines.join('\n');
-      i = j - 1;
-      
-      while (stack.length > 1 && stack[stack.length - 1].level >= level) {
-        stack.pop();
-      }
-      const parent = stack[stack.length - 1];
-      if (Array.isArray(parent.node)) {
-        parent.node.push(value);
-      } else {
-        parent.node[key] = value;
-      }
-      continue;
+  }
+
+  /**
+   * Record where a container starts, for parseWithDiagnostics()
+   */
+  locateNode(node, line, level) {
+    this.positions.set(node, { line, column: level + 1, entries: new Map() });
+  }
+
+  /**
+   * Record the line of `node[key]`
+   */
+  locate(node, key, line, level) {
+    this.positions.get(node).entries.set(key, { line, column: level + 1 });
+  }
+
+  setValue(frame, key, value, lineNum, level) {
+    if (Array.isArray(frame.node)) {
+      this.error('List items cannot be key-value pairs', lineNum, level + 1);
+    } else {
+      frame.node[key] = value;
+      if (this.positions !== null) this.locate(frame.node, key, lineNum, level);
     }
-    
-    let value = rawValue;
-    if (rawValue === NULL_VALUE) {
-      value = null;
-    } else if (rawValue === EMPTY_STRING) {
-      value = '';
-    } else if (rawValue !== null && rawValue !== '' && typeConversion) {
-      value = convertType(rawValue);
+  }
+
+  setRaw(frame, key, value, line, level) {
+    const node = frame.node;
+    if (Array.isArray(node)) {
+      node.push(value);
+      if (this.positions !== null) this.locate(node, node.length - 1, line, level);
+    } else {
+      node[key] = value;
+      if (this.positions !== null) this.locate(node, key, line, level);
     }
-    
-    while (stack.length > 1 && stack[stack.length - 1].level >= level) {
-      stack.pop();
+  }
+
+  badIndent(frame, level, lineNum) {
+    if (frame.node === null) {
+      frame.entries.push({ type: ENTRY_BAD_INDENT, level, line: lineNum });
+    } else {
+      this.error(`Invalid indentation level (expected ${frame.level + 1} tabs, found ${level})`, lineNum);
     }
-    
-    const parent = stack[stack.length - 1];
-    
-    if (level > parent.level + 1) {
-      if (strict) {
-        throw new TAMLError(`Invalid indentation level (expected ${parent.level + 1} tabs, found ${level})`, lineNum);
+  }
+
+  /**
+   * Place a bare child into its parent's container
+   */
+  place(parent, frame) {
+    const node = parent.node;
+    if (parent.record || parent.inRecord) frame.inRecord = true;
+    const record = this.records !== null && frame.key === this.recordKey && !frame.inRecord;
+
+    if (Array.isArray(node)) {
+      if (parent.kind === KIND_COLLECTION) {
+        // Collection of objects: bare key with children → push new object
+        const obj = {};
+        if (!record) node.push(obj);
+        if (this.positions !== null) {
+          this.locateNode(obj, frame.line, frame.level);
+          this.locate(node, node.length - 1, frame.line, frame.level);
+        }
+        this.forceObject(frame, obj, record);
+      } else {
+        node.push(frame.key);
+        if (this.positions !== null) this.locate(node, node.length - 1, frame.line, frame.level);
+        this.discard(frame, parent);
       }
-      continue;
+      return;
     }
-    
-    if (Array.isArray(parent.node)) {
-      // Parent is an array
-      if (hasValue) {
-        if (strict) {
-          throw new TAMLError('List items cannot be key-value pairs', lineNum);
+
+    const key = frame.key;
+    // Check for duplicate bare key at same level (key already exists)
+    if (key in node) {
+      const existing = node[key];
+      if (typeof existing === 'object' && existing !== null && !Array.isArray(existing)) {
+        // Convert single object to array
+        if (record) {
+          const line = this.recordLines.get(existing);
+          if (line !== undefined) this.addRecord(existing, line);
+          node[key] = [];
+        } else {
+          node[key] = [existing];
+          if (this.positions !== null) {
+            // The array takes the place of the first object
+            const first = this.positions.get(node).entries.get(key);
+            this.locateNode(node[key], first.line, first.column - 1);
+            this.locate(node[key], 0, first.line, first.column - 1);
+          }
         }
-        continue;
       }
-      // Collection of objects: bare key with children → push new object
-      if (parent.collectKey) {
+      if (Array.isArray(node[key])) {
         const obj = {};
-        parent.node.push(obj);
-        stack.push({ level, node: obj });
+        if (!record) node[key].push(obj);
+        if (this.positions !== null) {
+          this.locateNode(obj, frame.line, frame.level);
+          this.locate(node[key], node[key].length - 1, frame.line, frame.level);
+        }
+        this.forceObject(frame, obj, record);
+        return;
+      }
+    }
+
+    frame.role = ROLE_OWN;
+    frame.parentNode = node;
+    if (frame.kind !== 0) this.ownNode(frame);
+  }
+
+  /**
+   * Create the container for a frame whose own kind decides it
+   */
+  ownNode(frame) {
+    const node = frame.kind === KIND_OBJECT ? {} : [];
+    frame.parentNode[frame.key] = node;
+    if (this.positions !== null) {
+      this.locateNode(node, frame.line, frame.level);
+      this.locate(frame.parentNode, frame.key, frame.line, frame.level);
+    }
+    if (this.records !== null && frame.kind === KIND_OBJECT && frame.key === this.recordKey && !frame.inRecord) {
+      // May become the first record if the key repeats
+      this.recordLines.set(node, frame.line);
+    }
+    this.fill(frame, frame.parentNode[frame.key]);
+  }
+
+  forceObject(frame, obj, record) {
+    frame.role = ROLE_OBJECT;
+    frame.record = record;
+    frame.kind = KIND_OBJECT;
+    frame.scanning = false;
+    frame.bareKeyNames = null;
+    this.fill(frame, obj);
+    if (record && frame.closed) this.addRecord(obj, frame.line);
+  }
+
+  /**
+   * Give a frame its container and replay the children recorded so far.
+   * Replays run from a work list so deep documents don't exhaust the stack.
+   * The list is worked depth first, so a child's own children are in place
+   * before its next sibling is, as when lines are placed directly: a
+   * repeated key may add to the list its first occurrence made.
+   */
+  fill(frame, node) {
+    frame.node = node;
+    this.replays.push(frame);
+    if (this.replaying) return;
+
+    this.replaying = true;
+    const replays = this.replays;
+    while (replays.length > 0) {
+      const top = replays[replays.length - 1];
+      const entries = top.entries;
+      if (entries === null || top.replayed === entries.length) {
+        top.entries = null;
+        replays.pop();
       } else {
-        parent.node.push(key);
+        this.replay(top, entries[top.replayed++]);
       }
+    }
+    this.replaying = false;
+  }
+
+  replay(frame, entry) {
+    if (entry instanceof Frame) {
+      this.place(frame, entry);
+    } else if (entry.type === ENTRY_VALUE) {
+      this.setValue(frame, entry.key, entry.value, entry.line, entry.level);
+    } else if (entry.type === ENTRY_RAW) {
+      this.setRaw(frame, entry.key, entry.value, entry.line, entry.level);
     } else {
-      // Parent is an object
-      if (hasValue) {
-        // Leaf value
-        parent.node[key] = value;
-      } else {
-        // Check for duplicate bare key at same level (key already exists)
-        if (key in parent.node) {
-          const existing = parent.node[key];
-          if (typeof existing === 'object' && existing !== null && !Array.isArray(existing)) {
-            // Convert single object to array
-            parent.node[key] = [existing];
-          }
-          if (Array.isArray(parent.node[key])) {
-            const newObj = {};
-            parent.node[key].push(newObj);
-            stack.push({ level, node: newObj });
-            continue;
-          }
-        }
-        
-        // Parent node - look ahead to determine if it's an array or object
-        let isArray = false;
-        let hasListItems = false;
-        let hasKeyValuePairs = false;
-        let hasDuplicateBareKeys = false;
-        const bareKeyNames = new Set();
-        
-        for (let j = i + 1; j < lines.length; j++) {
-          const nextLine = lines[j];
-          if (nextLine.trim() === '' || nextLine.trimStart().startsWith('#')) {
-            continue;
-          }
-          const nextIndent = (nextLine.match(/^(\t*)/) || ['', ''])[1].length;
-          
-          if (nextIndent < level + 1) {
-            break;
-          }
-          
-          if (nextIndent === level + 1) {
-            const nextContent = nextLine.substring(nextIndent);
-            const nextTabIdx = nextContent.indexOf(TAB);
-            
-            if (nextTabIdx > 0) {
-              hasKeyValuePairs = true;
-            } else if (nextTabIdx === -1) {
-              // No tab - could be list item or parent node
-              const bareKey = nextContent.trim();
-              let hasChildren = false;
-              for (let k = j + 1; k < lines.length; k++) {
-                const checkLine = lines[k];
-                if (checkLine.trim() === '' || checkLine.trimStart().startsWith('#')) {
-                  continue;
-                }
-                const checkIndent = (checkLine.match(/^(\t*)/) || ['', ''])[1].length;
-                if (checkIndent > nextIndent) {
-                  hasChildren = true;
-                  break;
-                } else if (checkIndent <= nextIndent) {
-                  break;
-                }
-              }
-              
-              if (hasChildren) {
-                // Check for duplicate bare keys
-                if (bareKeyNames.has(bareKey)) {
-                  hasDuplicateBareKeys = true;
-                }
-                bareKeyNames.add(bareKey);
-              } else {
-                hasListItems = true;
-              }
-            }
-          }
-        }
-        
-        if (hasDuplicateBareKeys) {
-          isArray = true;
-        } else {
-          isArray = hasListItems && !hasKeyValuePairs;
+      this.badIndent(frame, entry.level, entry.line);
+    }
+  }
+
+  /**
+   * List items keep only their key. Anything nested under one is invalid
+   * indentation for the list, except raw text which is added to the list.
+   */
+  discard(frame, list) {
+    frame.role = ROLE_ITEM;
+    frame.scanning = false;
+
+    const stack = this.stack;
+    if (stack[frame.level + 1] === frame) {
+      stack.length = frame.level + 1;
+    }
+
+    this.discardEntries(frame, list);
+  }
+
+  discardEntries(frame, list) {
+    const pending = [frame];
+    const message = level => `Invalid indentation level (expected ${list.level + 1} tabs, found ${level})`;
+
+    while (pending.length > 0) {
+      const entry = pending.pop();
+      if (entry instanceof Frame) {
+        if (entry !== frame) {
+          entry.role = ROLE_ITEM;
+          entry.scanning = false;
+          this.error(message(entry.level), entry.line);
         }
-        
-        // Handle duplicate bare keys at current level
-        if (hasDuplicateBareKeys) {
-          parent.node[key] = [];
-          stack.push({ level, node: parent.node[key], collectKey: [...bareKeyNames][0] });
-        } else {
-          parent.node[key] = isArray ? [] : {};
-          stack.push({ level, node: parent.node[key] });
+        const entries = entry.entries;
+        entry.entries = null;
+        if (entries === null) continue;
+        for (let i = entries.length - 1; i >= 0; i--) {
+          pending.push(entries[i]);
         }
+      } else if (entry.type === ENTRY_RAW) {
+        list.node.push(entry.value);
+        if (this.positions !== null) this.locate(list.node, list.node.length - 1, entry.line, entry.level);
+      } else {
+        this.error(message(entry.level), entry.line);
       }
     }
   }
-  
-  return root;
+}
+
+/**
+ * Whitespace as removed by String.prototype.trim
+ */
+function isWhitespace(code) {
+  if (code <= SPACE_CODE) return code === SPACE_CODE || (code >= 0x09 && code <= 0x0d);
+  if (code < 0xa0) return false;
+  return code === 0xa0 || code === 0x1680 || (code >= 0x2000 && code <= 0x200a) ||
+    code === 0x2028 || code === 0x2029 || code === 0x202f || code === 0x205f ||
+    code === 0x3000 || code === 0xfeff;
+}
+
+/**
+ * Byte length of the isWhitespace() character encoded in UTF-8 at
+ * `bytes[pos]`, or 0 if there is none
+ */
+function whitespaceBytes(bytes, pos, end) {
+  const code = bytes[pos];
+  if (code < 0x80) return isWhitespace(code) ? 1 : 0;
+  if (code === 0xc2) return pos + 1 < end && bytes[pos + 1] === 0xa0 ? 2 : 0;
+  if (pos + 2 >= end) return 0;
+  const second = bytes[pos + 1];
+  const third = bytes[pos + 2];
+  switch (code) {
+    case 0xe1: // U+1680
+      return second === 0x9a && third === 0x80 ? 3 : 0;
+    case 0xe2: // U+2000-200A, U+2028, U+2029, U+202F, U+205F
+      if (second === 0x80) {
+        return (third >= 0x80 && third <= 0x8a) || third === 0xa8 || third === 0xa9 || third === 0xaf ? 3 : 0;
+      }
+      return second === 0x81 && third === 0x9f ? 3 : 0;
+    case 0xe3: // U+3000
+      return second === 0x80 && third === 0x80 ? 3 : 0;
+    case 0xef: // U+FEFF
+      return second === 0xbb && third === 0xbf ? 3 : 0;
+    default:
+      return 0;
+  }
 }
 
 /**
@@ -261,103 +1599,319 @@ function convertType(value) {
   }
 
   // Integer detection
-  if (/^-?\d+$/.test(value)) {
+  if (INTEGER_RE.test(value)) {
     return parseInt(value, 10)
   }
 
   // Float detection
-  if (/^-?\d+\.\d+$/.test(value)) {
+  if (FLOAT_RE.test(value)) {
     return parseFloat(value)
   }
 
   return value
 }
 
+// Converters for schema types. undefined means the text isn't of that type.
+const SCHEMA_TYPES = {
+  auto: convertType,
+  string: value => value,
+  number: value => {
+    if (INTEGER_RE.test(value)) return parseInt(value, 10);
+    return FLOAT_RE.test(value) ? parseFloat(value) : undefined;
+  },
+  integer: value => (INTEGER_RE.test(value) ? parseInt(value, 10) : undefined),
+  boolean: value => {
+    const lower = value.toLowerCase();
+    if (TRUTHY_VALUES.has(lower)) return true;
+    if (FALSY_VALUES.has(lower)) return false;
+    return undefined;
+  },
+  date: value => {
+    if (!ISO_DATE_RE.test(value)) return undefined;
+    const date = new Date(value);
+    return isNaN(date.getTime()) ? undefined : date;
+  }
+};
+
+const compiledSchemas = new WeakMap();
+
+/**
+ * Compile a schema into a tree with one node per key path segment.
+ * A schema maps dotted key paths to a type name (`string`, `number`,
+ * `integer`, `boolean`, `date` or `auto`) or a function from the value
+ * text to a value. `*` matches any key; a named key takes precedence.
+ * Paths follow the keys in the document, so the objects of a collection
+ * are reached through the repeated key (`users.user.id`).
+ */
+function compileSchema(schema) {
+  let root = compiledSchemas.get(schema);
+  if (root !== undefined) return root;
+
+  root = schemaNode();
+  for (const [path, type] of Object.entries(schema)) {
+    let node = root;
+    for (const key of path.split('.')) {
+      if (key === '*') {
+        if (node.any === null) node.any = schemaNode();
+        node = node.any;
+      } else {
+        if (node.children === null) node.children = new Map();
+        if (!node.children.has(key)) node.children.set(key, schemaNode());
+        node = node.children.get(key);
+      }
+    }
+    if (typeof type === 'function') {
+      node.type = type.name || 'value';
+      node.convert = type;
+    } else if (Object.prototype.hasOwnProperty.call(SCHEMA_TYPES, type)) {
+      node.type = type;
+      node.convert = SCHEMA_TYPES[type];
+    } else {
+      throw new TypeError(`Unknown schema type "${type}" for "${path}"`);
+    }
+  }
+
+  mergeWildcards(root);
+  compiledSchemas.set(schema, root);
+  return root;
+}
+
+function schemaNode() {
+  return { children: null, any: null, type: null, convert: null };
+}
+
+/**
+ * Copy `*` paths into their named siblings, so a lookup only has to try
+ * the named key and then `*`
+ */
+function mergeWildcards(root) {
+  const pending = [root];
+  while (pending.length > 0) {
+    const node = pending.pop();
+    if (node.children === null) continue;
+    for (const child of node.children.values()) {
+      if (node.any !== null) mergeSchema(child, node.any);
+      pending.push(child);
+    }
+    if (node.any !== null) pending.push(node.any);
+  }
+}
+
+function mergeSchema(target, source) {
+  if (target.convert === null) {
+    target.type = source.type;
+    target.convert = source.convert;
+  }
+  if (source.children !== null) {
+    if (target.children === null) target.children = new Map();
+    for (const [key, child] of source.children) {
+      if (!target.children.has(key)) target.children.set(key, schemaNode());
+      mergeSchema(target.children.get(key), child);
+    }
+  }
+  if (source.any !== null) {
+    if (target.any === null) target.any = schemaNode();
+    mergeSchema(target.any, source.any);
+  }
+}
+
+function schemaChild(node, key) {
+  if (node.children !== null) {
+    const child = node.children.get(key);
+    if (child !== undefined) return child;
+  }
+  return node.any;
+}
+
 /**
  * Serialize a JavaScript object to TAML format
  * @param {*} obj - JavaScript object to serialize
  * @param {Object} options - Serialization options
  * @param {number} options.indentLevel - Starting indentation level (default: 0)
  * @param {boolean} options.typeConversion - Convert native types to strings (default: true)
+ * @param {Function} options.replacer - Called as replacer.call(holder, key, value) before each
+ *   value is written, as in JSON.stringify; undefined leaves the entry out
  * @returns {string} TAML formatted string
  */
 export function stringify(obj, options = {}) {
-  const { indentLevel = 0, typeConversion = true } = options;
+  const { indentLevel = 0, typeConversion = true, replacer = null } = options;
   const lines = [];
   
-  serializeValue(obj, lines, indentLevel, typeConversion);
+  new Serializer(obj, indentLevel, typeConversion, replacer).write(lines, Infinity);
   
   return lines.join('\n');
 }
 
-function serializeValue(value, lines, level, typeConversion) {
-  if (value === null) {
-    return NULL_VALUE;
-  }
+/**
+ * Serialize a JavaScript object to TAML as a sequence of text chunks.
+ * Lines are batched into chunks of about `chunkSize` characters; the
+ * chunks concatenated give the same text as stringify().
+ * @param {*} obj - JavaScript object to serialize
+ * @param {Object} options - Serialization options, as for stringify()
+ * @param {number} options.chunkSize - Target chunk length in characters (default: 65536)
+ * @returns {Generator<string>} TAML text chunks
+ */
+export function* stringifyChunks(obj, options = {}) {
+  const { indentLevel = 0, typeConversion = true, replacer = null, chunkSize = 65536 } = options;
+  const serializer = new Serializer(obj, indentLevel, typeConversion, replacer);
+  const lines = [];
+  let first = true;
+  let done = false;
   
-  if (value === '') {
-    return EMPTY_STRING;
+  while (!done) {
+    done = serializer.write(lines, chunkSize);
+    if (lines.length === 0) continue;
+    const chunk = lines.join('\n');
+    lines.length = 0;
+    yield first ? chunk : '\n' + chunk;
+    first = false;
   }
+}
+
+/**
+ * Serialize a JavaScript object to TAML and write it to a stream in
+ * chunks, waiting for 'drain' whenever the stream's buffer is full
+ * @param {*} obj - JavaScript object to serialize
+ * @param {Writable} writable - Node.js Writable stream
+ * @param {Object} options - Serialization options, as for stringifyChunks()
+ * @param {boolean} options.end - End the stream when done (default: true)
+ * @returns {Promise<void>} Resolves once everything has been written
+ */
+export async function stringifyStream(obj, writable, options = {}) {
+  const { end = true } = options;
   
-  if (value instanceof Date) {
-    return value.toISOString();
+  for (const chunk of stringifyChunks(obj, options)) {
+    if (!writable.write(chunk)) {
+      await waitForStream(writable, 'drain');
+    }
   }
   
-  if (typeof value === 'string') {
-    // Check if string needs raw text block (contains tabs or newlines)
-    if (value.includes('\t') || value.includes('\n')) {
-      return RAW_TEXT;
+  if (end) {
+    const finished = waitForStream(writable, 'finish');
+    writable.end();
+    await finished;
+  }
+}
+
+/**
+ * Resolve on `event`, reject if the stream errors or closes first
+ */
+function waitForStream(writable, event) {
+  return new Promise((resolve, reject) => {
+    const cleanup = () => {
+      writable.removeListener(event, onEvent);
+      writable.removeListener('error', onError);
+      writable.removeListener('close', onClose);
+    };
+    const onEvent = () => {
+      cleanup();
+      resolve();
+    };
+    const onError = error => {
+      cleanup();
+      reject(error);
+    };
+    const onClose = () => {
+      cleanup();
+      reject(new Error('Stream closed before TAML output was written'));
+    };
+    writable.on(event, onEvent);
+    writable.on('error', onError);
+    writable.on('close', onClose);
+  });
+}
+
+// Serializer stack entries
+const SERIALIZE_OBJECT = 1;
+const SERIALIZE_LIST = 2;
+const SERIALIZE_COLLECTION = 3;
+
+/**
+ * Depth-first TAML serializer with an explicit stack, so output can be
+ * produced a batch of lines at a time
+ */
+class Serializer {
+  constructor(value, level, typeConversion, replacer = null) {
+    this.typeConversion = typeConversion;
+    this.replacer = replacer;
+    this.stack = [];
+    if (replacer !== null) {
+      value = replacer.call({ '': value }, '', value);
+      if (Array.isArray(value)) value = this.replaceItems(value);
     }
-    return value;
+    this.pushValue(value, level);
   }
   
-  if (typeof value === 'number' || typeof value === 'boolean') {
-    return String(value);
+  replaceItems(list) {
+    const items = [];
+    for (let i = 0; i < list.length; i++) {
+      const item = this.replacer.call(list, String(i), list[i]);
+      if (item !== undefined) items.push(item);
+    }
+    return items;
   }
   
-  if (Array.isArray(value)) {
-    // Check if this is a collection of objects (all items are plain objects)
-    const isCollectionOfObjects = value.length > 0 && value.every(
-      item => typeof item === 'object' && item !== null && !Array.isArray(item) && !(item instanceof Date)
-    );
-    if (isCollectionOfObjects) {
-      // Handled by the caller (serializeObject) which knows the key name
-      return null;
-    }
-    for (const item of value) {
-      const indent = TAB.repeat(level);
-      if (typeof item === 'object' && item !== null && !(item instanceof Date)) {
-        serializeObject(item, lines, level, typeConversion);
-      } else {
-        const serialized = serializeValue(item, [], level, typeConversion);
-        lines.push(indent + serialized);
+  pushValue(value, level) {
+    if (Array.isArray(value)) {
+      // Collection of objects is written by the parent object, which knows the key name
+      if (!isCollectionOfObjects(value)) {
+        this.stack.push({ type: SERIALIZE_LIST, items: value, index: 0, level, indent: TAB.repeat(level) });
       }
+    } else if (typeof value === 'object' && value !== null && !(value instanceof Date)) {
+      this.pushObject(value, level);
     }
-    return null;
   }
   
-  if (typeof value === 'object') {
-    serializeObject(value, lines, level, typeConversion);
-    return null;
+  pushObject(obj, level) {
+    this.stack.push({ type: SERIALIZE_OBJECT, items: Object.entries(obj), holder: obj, index: 0, level, indent: TAB.repeat(level) });
   }
   
-  return String(value);
-}
-
-function serializeRawText(key, value, lines, level) {
-  const indent = TAB.repeat(level);
-  const contentIndent = TAB.repeat(level + 1);
-  lines.push(indent + key + TAB + RAW_TEXT);
-  const rawLines = value.split('\n');
-  for (const rawLine of rawLines) {
-    lines.push(contentIndent + rawLine);
+  /**
+   * Append lines until their total length reaches `limit`.
+   * Returns true once the whole value has been written.
+   */
+  write(lines, limit) {
+    const stack = this.stack;
+    let length = 0;
+    
+    while (stack.length > 0) {
+      const top = stack[stack.length - 1];
+      if (top.index === top.items.length) {
+        stack.pop();
+        continue;
+      }
+      const item = top.items[top.index++];
+      const indent = top.indent;
+      const start = lines.length;
+      
+      if (top.type === SERIALIZE_LIST) {
+        if (typeof item === 'object' && item !== null && !(item instanceof Date)) {
+          this.pushObject(item, top.level);
+        } else {
+          lines.push(indent + serializeScalar(item));
+        }
+      } else if (top.type === SERIALIZE_COLLECTION) {
+        lines.push(indent + top.key);
+        this.pushObject(item, top.level + 1);
+      } else if (this.replacer === null) {
+        this.writeEntry(item[0], item[1], top.level, indent, lines);
+      } else {
+        const value = this.replacer.call(top.holder, item[0], item[1]);
+        if (value === undefined) continue;
+        this.writeEntry(item[0], Array.isArray(value) ? this.replaceItems(value) : value, top.level, indent, lines);
+      }
+      
+      if (limit !== Infinity) {
+        for (let i = start; i < lines.length; i++) {
+          length += lines[i].length + 1;
+        }
+        if (length >= limit) return false;
+      }
+    }
+    return true;
   }
-}
-
-function serializeObject(obj, lines, level, typeConversion) {
-  const indent = TAB.repeat(level);
   
-  for (const [key, value] of Object.entries(obj)) {
+  writeEntry(key, value, level, indent, lines) {
     if (value === null) {
       lines.push(indent + key + TAB + NULL_VALUE);
     } else if (value === '') {
@@ -367,35 +1921,68 @@ function serializeObject(obj, lines, level, typeConversion) {
     } else if (typeof value === 'string' && (value.includes('\t') || value.includes('\n'))) {
       serializeRawText(key, value, lines, level);
     } else if (typeof value === 'object') {
-      if (Array.isArray(value)) {
-        // Check for collection of objects → duplicate bare keys
-        const isCollectionOfObjects = value.length > 0 && value.every(
-          item => typeof item === 'object' && item !== null && !Array.isArray(item) && !(item instanceof Date)
-        );
-        if (isCollectionOfObjects) {
-          lines.push(indent + key);
-          const childIndent = TAB.repeat(level + 1);
-          for (const item of value) {
-            lines.push(childIndent + key);
-            serializeObject(item, lines, level + 2, typeConversion);
-          }
-        } else {
-          lines.push(indent + key);
-          serializeValue(value, lines, level + 1, typeConversion);
-        }
+      lines.push(indent + key);
+      // Check for collection of objects → duplicate bare keys
+      if (Array.isArray(value) && isCollectionOfObjects(value)) {
+        this.stack.push({ type: SERIALIZE_COLLECTION, key, items: value, index: 0, level: level + 1, indent: TAB.repeat(level + 1) });
       } else {
-        lines.push(indent + key);
-        serializeObject(value, lines, level + 1, typeConversion);
+        this.pushValue(value, level + 1);
       }
     } else {
-      const serialized = serializeValue(value, [], level, typeConversion);
-      lines.push(indent + key + TAB + serialized);
+      lines.push(indent + key + TAB + serializeScalar(value));
+    }
+  }
+}
+
+function serializeScalar(value) {
+  if (value === null) {
+    return NULL_VALUE;
+  }
+  
+  if (value === '') {
+    return EMPTY_STRING;
+  }
+  
+  if (value instanceof Date) {
+    return value.toISOString();
+  }
+  
+  if (typeof value === 'string') {
+    // Check if string needs raw text block (contains tabs or newlines)
+    if (value.includes('\t') || value.includes('\n')) {
+      return RAW_TEXT;
     }
+    return value;
+  }
+  
+  return String(value);
+}
+
+function isCollectionOfObjects(value) {
+  return value.length > 0 && value.every(
+    item => typeof item === 'object' && item !== null && !Array.isArray(item) && !(item instanceof Date)
+  );
+}
+
+function serializeRawText(key, value, lines, level) {
+  const indent = TAB.repeat(level);
+  const contentIndent = TAB.repeat(level + 1);
+  lines.push(indent + key + TAB + RAW_TEXT);
+  const rawLines = value.split('\n');
+  for (const rawLine of rawLines) {
+    lines.push(contentIndent + rawLine);
   }
 }
 
 export default {
   parse,
+  parseStream,
+  iterateRecords,
+  parseParallel,
+  parseLazy,
+  parseWithDiagnostics,
   stringify,
+  stringifyChunks,
+  stringifyStream,
   TAMLError
 };
@@ -0,0 +1,19 @@
+/**
+ * Worker thread for parseParallel(): parses sections of a shared TAML
+ * document on request
+ */
+
+import { parentPort, workerData } from 'worker_threads';
+import { parseSection, TAMLError } from './index.js';
+
+const { buffer, byteOffset, length, options } = workerData;
+const bytes = Buffer.from(buffer, byteOffset, length);
+
+parentPort.on('message', ({ start, end, header }) => {
+  try {
+    parentPort.postMessage({ result: parseSection(bytes, start, end, header, options) });
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    parentPort.postMessage({ error: { message: error.message, line: error.line } });
+  }
+});
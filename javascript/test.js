@@ -1,4 +1,5 @@
-import { parse, stringify, TAMLError } from './index.js';
+import { Readable, Writable } from 'stream';
+import { parse, parseLazy, parseWithDiagnostics, parseStream, iterateRecords, parseParallel, stringify, stringifyChunks, stringifyStream, TAMLError } from './index.js';
 
 // Test utilities
 let testsPassed = 0;
@@ -16,6 +17,18 @@ function test(name, fn) {
   }
 }
 
+async function testAsync(name, fn) {
+  try {
+    await fn();
+    console.log(`✓ ${name}`);
+    testsPassed++;
+  } catch (error) {
+    console.error(`✗ ${name}`);
+    console.error(`  ${error.message}`);
+    testsFailed++;
+  }
+}
+
 function assertEquals(actual, expected, message = '') {
   const actualStr = JSON.stringify(actual, null, 2);
   const expectedStr = JSON.stringify(expected, null, 2);
@@ -459,6 +472,432 @@ test('Round-trip duplicate bare keys', () => {
   assertEquals(reparsed, result);
 });
 
+console.log('\n--- Single-pass Parser Tests ---\n');
+
+test('Collection decided by a later duplicate bare key', () => {
+  const taml = 'items\n\tfirst\n\titem\n\t\tname\tA\n\titem\n\t\tname\tB';
+  const result = parse(taml);
+  assertEquals(result, { items: [{}, { name: 'A' }, { name: 'B' }] });
+});
+
+test('Object decided by a later key-value pair', () => {
+  const taml = 'server\n\tverbose\n\thost\tlocalhost';
+  const result = parse(taml);
+  assertEquals(result, { server: { verbose: {}, host: 'localhost' } });
+});
+
+test('Collection items with nested lists', () => {
+  const taml = 'users\n\tuser\n\t\tname\tAlice\n\t\troles\n\t\t\tadmin\n\t\t\tdev\n\tuser\n\t\tname\tBob\n\t\troles\n\t\t\tdev';
+  const result = parse(taml);
+  assertEquals(result, {
+    users: [
+      { name: 'Alice', roles: ['admin', 'dev'] },
+      { name: 'Bob', roles: ['dev'] }
+    ]
+  });
+});
+
+test('Strict mode reports the first error when the list is decided later', () => {
+  try {
+    parse('items\n\tfirst\n\t\tchild\n\tsecond\nbad\tva\tlue', { strict: true });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.line, 3);
+  }
+});
+
+test('Repeated key in a block decided later keeps document order', () => {
+  const record = '\tuser\n\t\ttags\n\t\t\ta\n\t\t\tb\n\t\ttags\n\t\t\ta\n';
+  const expected = { tags: ['a', 'b', { a: {} }] };
+  assertEquals(parse(`users\n${record}\tuser\n\t\tid\t1`).users[0], expected);
+  assertEquals(parse(`users\n\tuser\n\t\tid\t1\n${record}`).users[1], expected);
+});
+
+test('Parse very deeply nested document', () => {
+  const depth = 5000;
+  let taml = '';
+  for (let i = 0; i < depth; i++) {
+    taml += '\t'.repeat(i) + 'level\n';
+  }
+  taml += '\t'.repeat(depth) + 'value\t42';
+  let node = parse(taml);
+  for (let i = 0; i < depth; i++) {
+    node = node.level;
+  }
+  assertEquals(node, { value: 42 });
+});
+
+test('Parse CRLF line endings', () => {
+  const taml = 'server\r\n\thost\tlocalhost\r\n\tport\t8080\r\nfeatures\r\n\tlogging\r\n';
+  const result = parse(taml);
+  assertEquals(result, { server: { host: 'localhost', port: 8080 }, features: ['logging'] });
+});
+
+test('Trim surrounding whitespace from bare keys and values', () => {
+  const taml = 'name\tJohn  \nitems\n\t  first \n\t　second\n  \t# indented comment';
+  const result = parse(taml);
+  assertEquals(result, { name: 'John', items: ['first', 'second'] });
+});
+
+console.log('\n--- Byte Input Tests ---\n');
+
+test('parse accepts a Buffer or Uint8Array of UTF-8', () => {
+  const text = '﻿name\tZoë\ncity\t東京 \ncount\t42\nnotes\t...\n\tfirst line\n\t\tindented\n\nlist\n\t€\n\t# comment\n\tfr ';
+  const bytes = Buffer.from(text);
+  assertEquals(parse(bytes), parse(text));
+  assertEquals(parse(new Uint8Array(bytes)), parse(text));
+  assertEquals(parse(bytes).city, '東京');
+});
+
+test('parse on bytes reports strict errors like text', () => {
+  const text = 'name\tok\n\t\tdeep\tvalue';
+  try {
+    parse(Buffer.from(text), { strict: true });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.line, 2);
+  }
+});
+
+test('parse on bytes decodes short slices next to non-ASCII text', () => {
+  // Short ASCII keys and values beside multi-byte ones, including values
+  // that are ASCII in one line and not in the next
+  const text = 'é\ta\na\té\nab\tü€\nü€\tab\nkey\tZoë\nZoë\tkey\nlist\n\té\n\ta\n\t😀\n\tab';
+  assertEquals(parse(Buffer.from(text)), parse(text));
+  assertEquals(parse(new Uint8Array(Buffer.from(text))), parse(text));
+  assertEquals(parse(Buffer.from(text)).list, ['é', 'a', '😀', 'ab']);
+});
+
+console.log('\n--- Lazy Parser Tests ---\n');
+
+test('parseLazy matches parse', () => {
+  const text = 'name\tApp\nserver\n\thost\tlocalhost\nuser\n\tname\tAlice\nuser\n\tname\tBob\nnotes\t...\n\tline';
+  const lazy = parseLazy(text);
+  assertEquals(Object.keys(lazy), ['name', 'server', 'user', 'notes']);
+  assertEquals(lazy.user, [{ name: 'Alice' }, { name: 'Bob' }]);
+  assertEquals({ ...lazy }, parse(text));
+  assertEquals(JSON.stringify(lazy), JSON.stringify(parse(text)));
+});
+
+test('parseLazy only parses the keys that are read', () => {
+  const lazy = parseLazy('good\tyes\nbroken\n\t\tdeep\tvalue', { strict: true });
+  assertEquals(lazy.good, true);
+  try {
+    lazy.broken;
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.line, 3);
+  }
+});
+
+test('parseLazy matches parse on malformed input', () => {
+  const texts = [
+    'x\tv\tw\ny\t1',
+    'a\n\tb\t1\nx\tv\tw\n\tc\t2',
+    ' a\n\tb\t1\nc\t2',
+    'a\t1\n\tb\t...\n\t\tc\t...\nc\t2',
+    '\tb\t...\n\t\ttext\na\t1\n\ta\t...\n\t\tx\nb\n\tc\t1'
+  ];
+  for (const text of texts) {
+    const lazy = parseLazy(text);
+    // Read the last key first, so each is parsed without the ones before it
+    for (const key of Object.keys(lazy).reverse()) lazy[key];
+    assertEquals(Object.keys(lazy), Object.keys(parse(text)), text);
+    assertEquals({ ...lazy }, parse(text), text);
+  }
+});
+
+console.log('\n--- Streaming Parser Tests ---\n');
+
+// Split text into chunks that cut through lines
+function chunked(text, size) {
+  const chunks = [];
+  for (let i = 0; i < text.length; i += size) {
+    chunks.push(text.slice(i, i + size));
+  }
+  return Readable.from(chunks);
+}
+
+const streamDoc = `application\tMyApp
+server
+\thost\tlocalhost
+\tport\t8080
+description\t...
+\tLine one
+\t\tindented
+users
+\tuser
+\t\tname\tAlice
+\t\troles
+\t\t\tadmin
+\tuser
+\t\tname\tBob
+\t\troles
+\t\t\tdev`;
+
+await testAsync('parseStream matches parse across chunk boundaries', async () => {
+  for (const size of [1, 3, 7, 64]) {
+    const result = await parseStream(chunked(streamDoc, size));
+    assertEquals(result, parse(streamDoc), `chunk size ${size}`);
+  }
+});
+
+await testAsync('parseStream decodes UTF-8 split across Buffer chunks', async () => {
+  const bytes = Buffer.from('name\tZoë\ncity\t東京');
+  const chunks = [];
+  for (let i = 0; i < bytes.length; i++) {
+    chunks.push(bytes.subarray(i, i + 1));
+  }
+  const result = await parseStream(Readable.from(chunks));
+  assertEquals(result, { name: 'Zoë', city: '東京' });
+});
+
+await testAsync('parseStream strict mode rejects with line number', async () => {
+  try {
+    await parseStream(chunked('name\tok\n  bad\tindent', 4), { strict: true });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.line, 2);
+  }
+});
+
+await testAsync('iterateRecords yields each collection object', async () => {
+  const records = [];
+  for await (const record of iterateRecords(chunked(streamDoc, 5), 'user')) {
+    records.push(record);
+  }
+  assertEquals(records, [
+    { name: 'Alice', roles: ['admin'] },
+    { name: 'Bob', roles: ['dev'] }
+  ]);
+});
+
+await testAsync('iterateRecords yields repeated top-level keys', async () => {
+  const taml = 'server\n\thost\ta\nserver\n\thost\tb\nserver\n\thost\tc';
+  const records = [];
+  for await (const record of iterateRecords(chunked(taml, 6), 'server')) {
+    records.push(record);
+  }
+  assertEquals(records, [{ host: 'a' }, { host: 'b' }, { host: 'c' }]);
+});
+
+console.log('\n--- Streaming Stringify Tests ---\n');
+
+const streamObj = parse(streamDoc);
+
+test('stringifyChunks joins to stringify output', () => {
+  const expected = stringify(streamObj);
+  for (const chunkSize of [1, 10, 65536]) {
+    const chunks = [...stringifyChunks(streamObj, { chunkSize })];
+    assertEquals(chunks.join(''), expected, `chunk size ${chunkSize}`);
+  }
+  assertEquals([...stringifyChunks({ a: 1, b: 2 }, { chunkSize: 1 })], ['a\t1', '\nb\t2']);
+});
+
+await testAsync('stringifyStream waits for drain on a slow writable', async () => {
+  const received = [];
+  let finished = false;
+  const writable = new Writable({
+    highWaterMark: 8,
+    write(chunk, encoding, callback) {
+      received.push(chunk.toString());
+      setImmediate(callback);
+    },
+    final(callback) {
+      finished = true;
+      callback();
+    }
+  });
+  await stringifyStream(streamObj, writable, { chunkSize: 16 });
+  assertEquals(finished, true);
+  assertEquals(received.join(''), stringify(streamObj));
+});
+
+await testAsync('stringifyStream rejects when the writable errors', async () => {
+  const writable = new Writable({
+    highWaterMark: 1,
+    write(chunk, encoding, callback) {
+      callback(new Error('disk full'));
+    }
+  });
+  try {
+    await stringifyStream(streamObj, writable, { chunkSize: 4 });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    assertEquals(error.message, 'disk full');
+  }
+});
+
+console.log('\n--- Parallel Parser Tests ---\n');
+
+await testAsync('parseParallel merges sections in document order', async () => {
+  for (const input of [streamDoc, Buffer.from(streamDoc)]) {
+    const result = await parseParallel(input, { workers: 2, partitionSize: 16 });
+    assertEquals(result, parse(streamDoc));
+    assertEquals(Object.keys(result), ['application', 'server', 'description', 'users']);
+  }
+});
+
+await testAsync('parseParallel handles keys repeated across sections', async () => {
+  const text = 'user\n\tname\tAlice\nuser\n\tname\tBob\nuser\n\tname\tCarol';
+  const result = await parseParallel(text, { workers: 2, partitionSize: 1 });
+  assertEquals(result, parse(text));
+});
+
+await testAsync('parseParallel matches parse on malformed input', async () => {
+  const texts = [
+    'a\t1\nb\n\tx\t1\nc\tv\tw\n\ty\t2\nd\t3',
+    'a\n\tx\t1\n  b\n\ty\t2\n\fc\n\tz\t3',
+    'a\t...\n\tline\n# note\n\tkey\t1\nb\t2',
+    'x\tv\tw\ny\t1'
+  ];
+  for (const text of texts) {
+    for (const partitionSize of [1, 5, 12]) {
+      assertEquals(await parseParallel(text, { workers: 2, partitionSize }), parse(text), text);
+    }
+  }
+});
+
+await testAsync('parseParallel merges bare keys repeated across sections', async () => {
+  const text = 'a\t1\nuser\n\tn\t1\nitems\n\tx\nuser\n\tn\t2\nitems\n\ty\na\nuser\t5\nuser\n\tn\t3\nuser\n\tn\t4';
+  for (const partitionSize of [1, 8, 20]) {
+    assertEquals(await parseParallel(text, { workers: 3, partitionSize }), parse(text));
+  }
+});
+
+await testAsync('parseParallel splits the collection of a single top-level key', async () => {
+  const records = Array.from({ length: 20 }, (_, i) => `\tuser\n\t\tid\t${i}\n\t\ttags\n\t\t\ta\n`).join('');
+  const text = `title\tExport\nusers\n${records}count\t20\ngroups\n\tgroup\n\t\tid\t1\n\tgroup\n\t\tid\t2`;
+  const result = await parseParallel(text, { workers: 2, partitionSize: 40 });
+  assertEquals(result, parse(text));
+  assertEquals(result.users.length, 20);
+});
+
+await testAsync('parseParallel rejects a worker count below one', async () => {
+  try {
+    await parseParallel('a\t1', { workers: 0 });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof RangeError)) throw error;
+  }
+});
+
+await testAsync('parseParallel strict mode rejects with line number', async () => {
+  try {
+    await parseParallel('a\t1\nb\t2\nc\n  bad', { strict: true, partitionSize: 1 });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.line, 4);
+  }
+});
+
+console.log('\n--- Schema and Hook Tests ---\n');
+
+const schemaDoc = 'server\n\tport\t08080\n\tcode\t2024-01-05\n\tdebug\tno\nusers\n\tuser\n\t\tid\t1\n\t\tname\ttrue\n\tuser\n\t\tid\tx\n\t\tname\tBob';
+
+test('Schema types override inference by key path', () => {
+  const schema = { 'server.port': 'integer', 'server.code': 'string', 'users.*.name': 'string', 'users.user.id': 'integer' };
+  const result = parse(schemaDoc, { schema });
+  assertEquals(result.server, { port: 8080, code: '2024-01-05', debug: false });
+  assertEquals(result.users, [{ id: 1, name: 'true' }, { id: 'x', name: 'Bob' }]);
+});
+
+test('Schema applies with typeConversion disabled and accepts functions', () => {
+  const schema = { 'server.port': Number, 'server.debug': 'boolean' };
+  const result = parse(schemaDoc, { schema, typeConversion: false });
+  assertEquals(result.server, { port: 8080, code: '2024-01-05', debug: false });
+});
+
+test('Schema type mismatches are errors in strict mode', () => {
+  try {
+    parse(schemaDoc, { schema: { 'users.user.id': 'integer' }, strict: true });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.line, 10);
+  }
+});
+
+test('Schema number and date accept only the forms parse() converts', () => {
+  const schema = { 'n.*': 'number', 'd.*': 'date' };
+  const doc = 'n\n\ta\t-12\n\tb\t1.5\n\tc\tInfinity\n\td\t0x1F\n\te\t 12 \n\tf\t1e3\n\tg\t\n' +
+    'd\n\ta\t2024-01-05\n\tb\t2024-01-05T10:30:00Z\n\tc\tJan 5 2024\n\td\t1704412800000';
+  const result = parse(doc, { schema });
+  assertEquals(result.n, { a: -12, b: 1.5, c: 'Infinity', d: '0x1F', e: ' 12', f: '1e3', g: '' });
+  assertEquals(result.d.a.getTime(), Date.parse('2024-01-05'));
+  assertEquals(result.d.b.getTime(), Date.parse('2024-01-05T10:30:00Z'));
+  assertEquals([result.d.c, result.d.d], ['Jan 5 2024', '1704412800000']);
+  for (const [path, text] of [['n.x', 'Infinity'], ['n.x', '0x1F'], ['n.x', ' 12 '], ['n.x', ''], ['d.x', 'Jan 5 2024']]) {
+    try {
+      parse(`${path.split('.')[0]}\n\tx\t${text}`, { schema, strict: true });
+      throw new Error(`Should have thrown for "${text}"`);
+    } catch (error) {
+      if (!(error instanceof TAMLError)) throw error;
+      assertEquals(error.message, `Line 2: Value "${text.trimEnd()}" is not a valid ${path === 'n.x' ? 'number' : 'date'}`);
+    }
+  }
+});
+
+test('Reviver transforms values innermost first', () => {
+  const seen = [];
+  const result = parse('a\t1\nb\n\tc\t2\n\td\tdrop', {
+    reviver(key, value) {
+      seen.push(key);
+      if (key === 'd') return undefined;
+      return typeof value === 'number' ? value * 10 : value;
+    }
+  });
+  assertEquals(result, { a: 10, b: { c: 20 } });
+  assertEquals(seen, ['a', 'c', 'd', 'b', '']);
+});
+
+test('Replacer transforms or drops values before writing', () => {
+  const result = stringify({ name: 'App', secret: 'x', ports: [80, 443] }, {
+    replacer(key, value) {
+      if (key === 'secret') return undefined;
+      return key === '1' ? 8443 : value;
+    }
+  });
+  assertEquals(result, 'name\tApp\nports\n\t80\n\t8443');
+});
+
+console.log('\n--- Diagnostics Tests ---\n');
+
+const diagnosticsDoc = 'name\tok\n  bad\nitems\n\tone\n\ttwo\tx\n\t\tdeep\nvalue\ta\tb';
+
+test('parseWithDiagnostics returns the value and every error', () => {
+  const { value, diagnostics } = parseWithDiagnostics(diagnosticsDoc);
+  assertEquals(value, parse(diagnosticsDoc));
+  assertEquals(diagnostics.map(d => [d.line, d.column]), [[2, 1], [6, 1], [7, 8]]);
+  assertEquals(diagnostics[2].message, 'Value contains invalid tab character');
+});
+
+test('First diagnostic is the strict mode error', () => {
+  const { diagnostics } = parseWithDiagnostics(diagnosticsDoc);
+  try {
+    parse(diagnosticsDoc, { strict: true });
+    throw new Error('Should have thrown');
+  } catch (error) {
+    if (!(error instanceof TAMLError)) throw error;
+    assertEquals(error.message, `Line ${diagnostics[0].line}: ${diagnostics[0].message}`);
+  }
+});
+
+test('parseWithDiagnostics maps nodes to positions', () => {
+  const text = 'server\n\thost\tlocalhost\nusers\n\tuser\n\t\tname\tA\n\tuser\n\t\tname\tB';
+  const { value, positions } = parseWithDiagnostics(text, { positions: true });
+  assertEquals(positions.get(value).entries.get('users'), { line: 3, column: 1 });
+  assertEquals(positions.get(value.server).entries.get('host'), { line: 2, column: 2 });
+  assertEquals(positions.get(value.users).entries.get(1), { line: 6, column: 2 });
+  assertEquals(positions.get(value.users[1]).line, 6);
+  assertEquals(positions.get(value.users[1]).entries.get('name'), { line: 7, column: 3 });
+});
+
 // Summary
 console.log(`\n${testsPassed} tests passed, ${testsFailed} tests failed`);
 process.exit(testsFailed > 0 ? 1 : 0);
@@ -0,0 +1,156 @@
+"""
+Benchmark fixtures and regression checks
+
+Run with ``python -m pytest benchmarks``. By default only the scaling checks
+can fail, since they compare a machine with itself. With ``--bench-compare``
+(or ``TAML_BENCH_COMPARE=1``) each result is also compared with
+``benchmarks/baseline.json``, and the test fails when it is slower than the
+baseline times ``--bench-tolerance`` or uses more than 25% more peak memory;
+the baseline is only meaningful on the machine that recorded it.
+``--update-baseline`` records the measured results as the new baseline.
+
+pytest-benchmark is used for timing when it is installed; otherwise a small
+built-in timer with the same ``benchmark(fn)`` interface takes its place.
+"""
+
+import json
+import os
+import platform
+import statistics
+import sys
+import time
+from types import SimpleNamespace
+from typing import Any, Callable, Dict
+
+import pytest
+
+BASELINE_PATH = os.path.join(os.path.dirname(__file__), 'baseline.json')
+
+# Peak memory may grow this much over the baseline before a test fails
+MEMORY_TOLERANCE = 1.25
+
+try:
+    import pytest_benchmark  # noqa: F401
+    HAVE_PYTEST_BENCHMARK = True
+except ImportError:
+    HAVE_PYTEST_BENCHMARK = False
+
+
+def pytest_addoption(parser):
+    group = parser.getgroup('taml benchmarks')
+    group.addoption('--update-baseline', action='store_true',
+                    help='Write the measured results to benchmarks/baseline.json')
+    group.addoption('--bench-compare', action='store_true',
+                    default=os.environ.get('TAML_BENCH_COMPARE', '') not in ('', '0'),
+                    help='Fail on regressions against benchmarks/baseline.json '
+                         '(default: off, or TAML_BENCH_COMPARE=1)')
+    group.addoption('--bench-tolerance', type=float, default=2.0,
+                    help='Fail when a median time exceeds the baseline by this factor (default: 2.0)')
+
+
+class _Timer:
+    """Stand-in for the pytest-benchmark fixture: runs fn for at least 5 rounds and 0.5 s"""
+    
+    min_rounds = 5
+    min_time = 0.5
+    
+    def __init__(self):
+        self.stats = None
+    
+    def __call__(self, fn: Callable[..., Any], *args: Any, **kwargs: Any) -> Any:
+        result = fn(*args, **kwargs)  # warm up
+        times = []
+        start = time.perf_counter()
+        while len(times) < self.min_rounds or time.perf_counter() - start < self.min_time:
+            t = time.perf_counter()
+            fn(*args, **kwargs)
+            times.append(time.perf_counter() - t)
+        self.stats = SimpleNamespace(stats=SimpleNamespace(
+            median=statistics.median(times), min=min(times), rounds=len(times)
+        ))
+        return result
+
+
+if not HAVE_PYTEST_BENCHMARK:
+    @pytest.fixture
+    def benchmark():
+        return _Timer()
+
+
+class Results:
+    """Results of this run and the stored baseline"""
+    
+    def __init__(self, config):
+        self.config = config
+        self.measured: Dict[str, Dict[str, float]] = {}
+        self.baseline: Dict[str, Dict[str, float]] = {}
+        if os.path.exists(BASELINE_PATH):
+            with open(BASELINE_PATH, encoding='utf-8') as f:
+                self.baseline = json.load(f)['results']
+    
+    def record(self, name: str, **values: float) -> None:
+        """Store results for a benchmark and fail if they regressed"""
+        self.measured.setdefault(name, {}).update(values)
+        if self.config.getoption('--update-baseline') or not self.config.getoption('--bench-compare'):
+            return
+        
+        old = self.baseline.get(name, {})
+        tolerance = self.config.getoption('--bench-tolerance')
+        if 'median_s' in values and 'median_s' in old and values['median_s'] > old['median_s'] * tolerance:
+            pytest.fail(f'{name}: median {values["median_s"] * 1000:.1f} ms is more than {tolerance}x '
+                        f'the baseline {old["median_s"] * 1000:.1f} ms')
+        if 'peak_bytes' in values and 'peak_bytes' in old and values['peak_bytes'] > old['peak_bytes'] * MEMORY_TOLERANCE:
+            pytest.fail(f'{name}: peak memory {values["peak_bytes"] // 1024} KiB is more than '
+                        f'{MEMORY_TOLERANCE}x the baseline {old["peak_bytes"] // 1024} KiB')
+    
+    def save(self) -> None:
+        results = dict(self.baseline)
+        for name, values in self.measured.items():
+            results.setdefault(name, {}).update(values)
+        report = {
+            'environment': {
+                'python': platform.python_version(),
+                'implementation': platform.python_implementation(),
+                'platform': sys.platform,
+                'machine': platform.machine(),
+            },
+            'results': dict(sorted(results.items())),
+        }
+        with open(BASELINE_PATH, 'w', encoding='utf-8') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+
+
+def pytest_configure(config):
+    config._taml_results = Results(config)
+
+
+@pytest.fixture
+def results(request) -> Results:
+    return request.config._taml_results
+
+
+def pytest_sessionfinish(session):
+    results = getattr(session.config, '_taml_results', None)
+    if results is not None and results.measured and session.config.getoption('--update-baseline'):
+        results.save()
+
+
+def pytest_terminal_summary(terminalreporter, config):
+    results = getattr(config, '_taml_results', None)
+    if results is None or not results.measured:
+        return
+    terminalreporter.section('taml benchmarks')
+    for name, values in sorted(results.measured.items()):
+        parts = []
+        if 'median_s' in values:
+            parts.append(f'{values["median_s"] * 1000:10.2f} ms')
+        if 'mb_per_s' in values:
+            parts.append(f'{values["mb_per_s"]:8.2f} MB/s')
+        if 'peak_bytes' in values:
+            parts.append(f'peak {values["peak_bytes"] // 1024:8d} KiB')
+        if 'exponent' in values:
+            parts.append(f'growth n^{values["exponent"]:.2f}')
+        terminalreporter.write_line(f'{name:55s} ' + '  '.join(parts))
+    if config.getoption('--update-baseline'):
+        terminalreporter.write_line(f'Baseline written to {BASELINE_PATH}')
@@ -0,0 +1,69 @@
+"""Benchmark documents: the shared examples and generated large, deep and wide documents"""
+
+import os
+from typing import List, Tuple
+
+EXAMPLES_DIR = os.path.join(os.path.dirname(__file__), '..', '..', 'examples')
+
+
+def example_documents() -> List[Tuple[str, str]]:
+    """(name, text) of each example document"""
+    if not os.path.isdir(EXAMPLES_DIR):
+        return []
+    documents = []
+    for name in sorted(os.listdir(EXAMPLES_DIR)):
+        if name.endswith('.taml'):
+            with open(os.path.join(EXAMPLES_DIR, name), encoding='utf-8') as f:
+                documents.append((f'examples/{name}', f.read()))
+    return documents
+
+
+def large_document(records: int) -> str:
+    """Many records, like an exported table"""
+    lines = ['users']
+    for i in range(records):
+        lines.append('\tuser')
+        lines.append(f'\t\tid\t{i}')
+        lines.append(f'\t\tname\tUser {i}')
+        lines.append(f'\t\temail\tuser{i}@example.com')
+        lines.append(f'\t\tactive\t{"true" if i % 3 else "false"}')
+        lines.append(f'\t\tscore\t{i * 1.37:.2f}')
+        lines.append(f'\t\tcreated\t2024-01-{1 + i % 28:02d}')
+        lines.append('\t\troles')
+        lines.append('\t\t\tviewer')
+        if i % 5 == 0:
+            lines.append('\t\t\teditor')
+    return '\n'.join(lines)
+
+
+def deep_document(depth: int) -> str:
+    """One long chain of nested objects"""
+    lines = []
+    for i in range(depth):
+        lines.append('\t' * i + f'level{i}')
+        lines.append('\t' * (i + 1) + f'value\t{i}')
+    return '\n'.join(lines)
+
+
+def wide_document(width: int) -> str:
+    """A few containers with very many direct children"""
+    lines = ['settings']
+    lines.extend(f'\tkey{i}\tvalue {i}' for i in range(width))
+    lines.append('tags')
+    lines.extend(f'\ttag{i}' for i in range(width))
+    return '\n'.join(lines)
+
+
+# Generators and the size used for throughput and memory benchmarks. The
+# deep document stays within the recursion limit of stringify() at twice its size.
+GENERATED = {
+    'large': (large_document, 10000),
+    'deep': (deep_document, 300),
+    'wide': (wide_document, 50000),
+}
+
+
+def documents() -> List[Tuple[str, str]]:
+    """(name, text) of every benchmark document"""
+    generated = [(f'generated/{name}', make(size)) for name, (make, size) in GENERATED.items()]
+    return example_documents() + generated
@@ -0,0 +1,88 @@
+"""Throughput, peak memory and scaling benchmarks for parse and stringify"""
+
+import gc
+import math
+import statistics
+import time
+import tracemalloc
+
+import pytest
+
+import taml
+from .documents import GENERATED, documents
+
+DOCUMENTS = documents()
+IDS = [name for name, _ in DOCUMENTS]
+
+# Growth in time with document size above which a test fails; linear is 1
+MAX_EXPONENT = 1.4
+
+# A scaling measurement over the limit is repeated this many times in all
+# before the test fails, so one slow run on a busy machine doesn't fail it
+SCALING_ATTEMPTS = 3
+
+def operations(text):
+    value = taml.parse(text)
+    return {
+        'parse': lambda: taml.parse(text),
+        'stringify': lambda: taml.stringify(value),
+    }
+
+
+@pytest.mark.parametrize('operation', ['parse', 'stringify'])
+@pytest.mark.parametrize('name,text', DOCUMENTS, ids=IDS)
+def test_throughput(benchmark, results, name, text, operation):
+    fn = operations(text)[operation]
+    benchmark(fn)
+    if benchmark.stats is None:
+        pytest.skip('timing disabled')
+    median = benchmark.stats.stats.median
+    size = len(text.encode('utf-8'))
+    results.record(f'{operation}[{name}]', median_s=median, mb_per_s=size / 1e6 / median)
+
+
+@pytest.mark.parametrize('operation', ['parse', 'stringify'])
+@pytest.mark.parametrize('name,text', DOCUMENTS, ids=IDS)
+def test_peak_memory(results, name, text, operation):
+    fn = operations(text)[operation]
+    tracemalloc.start()
+    try:
+        fn()
+        _, peak = tracemalloc.get_traced_memory()
+    finally:
+        tracemalloc.stop()
+    results.record(f'{operation}[{name}]', peak_bytes=peak)
+
+
+def median_time(fn, rounds=5):
+    """Median of several runs, without collector pauses skewing small documents"""
+    times = []
+    gc.collect()
+    gc.disable()
+    try:
+        for _ in range(rounds):
+            start = time.perf_counter()
+            fn()
+            times.append(time.perf_counter() - start)
+    finally:
+        gc.enable()
+    return statistics.median(times)
+
+
+@pytest.mark.parametrize('operation', ['parse', 'stringify'])
+@pytest.mark.parametrize('family', sorted(GENERATED))
+def test_scaling(results, family, operation):
+    """Time must grow about linearly with the size of the document"""
+    make, size = GENERATED[family]
+    # An 8x size ratio, so a slower-than-linear part stands out from the noise
+    small, big = make(size // 4), make(size * 2)
+    small_fn, big_fn = operations(small)[operation], operations(big)[operation]
+    ratio = math.log(len(big) / len(small))
+    for _ in range(SCALING_ATTEMPTS):
+        exponent = math.log(median_time(big_fn) / median_time(small_fn)) / ratio
+        if exponent < MAX_EXPONENT:
+            break
+    results.record(f'{operation}-scaling[{family}]', exponent=exponent)
+    assert exponent < MAX_EXPONENT, (
+        f'{operation} of {family} documents grows as n^{exponent:.2f}; expected about linear'
+    )
@@ -3,8 +3,11 @@ TAML (Tab Accessible Markup Language) Parser and Serializer
 Version 0.1.0
 """
 
-from .parser import parse, TAMLError
-from .serializer import stringify
+from .parser import parse, load, iterparse, iter_records, TAMLError
+from .serializer import stringify, dump
+from .typed import load_as
+from .batch import load_many
+from .record import Record
 
 __version__ = "0.1.0"
-__all__ = ["parse", "stringify", "TAMLError"]
+__all__ = ["parse", "load", "load_many", "iterparse", "iter_records", "load_as", "stringify", "dump", "Record", "TAMLError"]
@@ -0,0 +1,83 @@
+"""TAML batch loading - Parse many files in worker processes"""
+
+import os
+from concurrent.futures import ProcessPoolExecutor
+from functools import partial
+from typing import Any, Dict, Iterable, List, Optional, Union
+
+from .parser import TAMLError, load
+
+# Fewer files than this per worker are loaded faster without starting processes
+_MIN_FILES_PER_WORKER = 8
+
+# Chunks dispatched per worker; more balances uneven files, fewer saves round trips
+_CHUNKS_PER_WORKER = 4
+
+
+def load_many(paths: Iterable[Union[str, bytes, os.PathLike]], workers: Optional[int] = None,
+              strict: bool = False, type_conversion: bool = True, schema: Optional[Dict[str, Any]] = None,
+              chunksize: Optional[int] = None) -> List[Dict[str, Any]]:
+    """
+    Parse many TAML files in a pool of worker processes
+    
+    The parser is CPU-bound, so processes rather than threads are used. Paths
+    are dispatched to the workers in chunks and the results are returned in the
+    order of the paths. Small batches are loaded in this process, where starting
+    the pool would cost more than it saves.
+    
+    Args:
+        paths: Paths of UTF-8 files
+        workers: Number of worker processes (default: the number of CPUs)
+        strict: Enable strict parsing (default: False)
+        type_conversion: Convert string values to native types (default: True)
+        schema: Value types for dotted key paths, as for parse(); callable
+            types must be picklable, such as module-level functions
+        chunksize: Paths sent to a worker at a time (default: about a quarter
+            of each worker's share)
+    
+    Returns:
+        Parsed dictionary of each file, in the order of paths
+    
+    Raises:
+        TAMLError: If a file can't be read, or parsing it fails in strict mode;
+            the message starts with the path, and the original error is the cause
+        ValueError: If workers or chunksize is less than 1
+    """
+    paths = list(paths)
+    if workers is None:
+        workers = os.cpu_count() or 1
+    if workers < 1:
+        raise ValueError('workers must be at least 1')
+    if chunksize is not None and chunksize < 1:
+        raise ValueError('chunksize must be at least 1')
+    
+    load_one = partial(_load_file, strict=strict, type_conversion=type_conversion, schema=schema)
+    workers = min(workers, len(paths) // _MIN_FILES_PER_WORKER)
+    if workers <= 1:
+        return _collect(paths, map(load_one, paths))
+    
+    if chunksize is None:
+        chunksize = max(1, -(-len(paths) // (workers * _CHUNKS_PER_WORKER)))
+    with ProcessPoolExecutor(max_workers=workers) as executor:
+        return _collect(paths, executor.map(load_one, paths, chunksize=chunksize))
+
+
+def _load_file(path: Union[str, bytes, os.PathLike], **options: Any) -> Union[Dict[str, Any], Exception]:
+    """Parsed file, or the error loading it, returned so _collect() can add the path"""
+    try:
+        return load(path, **options)
+    except Exception as exc:
+        return exc
+
+
+def _collect(paths: List[Union[str, bytes, os.PathLike]],
+             results: Iterable[Union[Dict[str, Any], Exception]]) -> List[Dict[str, Any]]:
+    """Results in the order of paths; the first error is raised with its path"""
+    loaded = []
+    for path, result in zip(paths, results):
+        if isinstance(result, Exception):
+            error = TAMLError(f'{os.fsdecode(path)}: {result}')
+            error.line = getattr(result, 'line', None)
+            raise error from result
+        loaded.append(result)
+    return loaded
@@ -1,19 +1,33 @@
 """TAML Parser - Parse TAML formatted text into Python objects"""
 
+import mmap
+import os
 import re
+from collections import deque
+from functools import lru_cache
 from datetime import date, datetime, timezone
-from typing import Any, Dict, List, Optional, Tuple, Union
+from typing import Any, Callable, Deque, Dict, Iterable, Iterator, List, Optional, Tuple, Union
+
+from .record import compact_collections
 
 TAB = '\t'
 NULL_VALUE = '~'
 EMPTY_STRING = '""'
 RAW_TEXT_MARKER = '...'
 
+# Bytes of a memory-mapped file decoded at a time by load()
+_LOAD_BLOCK_SIZE = 1 << 20
+
+# Distinct keys interned per parse; collections repeat the first keys they see
+_MAX_INTERNED_KEYS = 4096
+
 # Boolean truthy/falsy values (lowercase, case-insensitive detection)
 _TRUTHY_VALUES = frozenset({'true', 'yes', 'on'})
 _FALSY_VALUES = frozenset({'false', 'no', 'off'})
+_BOOLEAN_FIRST = frozenset('tTyYoOfFnN')
 
 # ISO 8601 date/time patterns
+_INTEGER_RE = re.compile(r'^-?\d+$')
 _YEAR_MONTH_RE = re.compile(r'^(\d{4})-(\d{2})$')
 _DATE_ONLY_RE = re.compile(r'^\d{4}-\d{2}-\d{2}$')
 _DATETIME_RE = re.compile(
@@ -34,7 +48,8 @@ class TAMLError(Exception):
             super().__init__(message)
 
 
-def parse(text: str, strict: bool = False, type_conversion: bool = True) -> Dict[str, Any]:
+def parse(text: str, strict: bool = False, type_conversion: bool = True,
+          schema: Optional[Dict[str, Any]] = None, compact: bool = False) -> Dict[str, Any]:
     """
     Parse a TAML string into a Python dictionary
     
@@ -42,6 +57,43 @@ def parse(text: str, strict: bool = False, type_conversion: bool = True) -> Dict
         text: TAML formatted text
         strict: Enable strict parsing (default: False)
         type_conversion: Convert string values to native types (default: True)
+        schema: Value types for dotted key paths, which skip type inference.
+            Types are 'string', 'number', 'integer', 'boolean', 'date' and
+            'auto', or a callable that takes the value text and raises
+            ValueError if it is invalid. '*' matches any key.
+        compact: Return the objects of each collection whose objects all have
+            the same keys as Record tuples instead of dicts (default: False)
+    
+    Returns:
+        Parsed Python dictionary
+    
+    Raises:
+        TAMLError: If parsing fails in strict mode, including a value that
+            doesn't match its schema type
+    """
+    parser = _Parser(strict, type_conversion, schema, compact=compact)
+    feed = parser.feed
+    for line in text.split('\n'):
+        feed(line)
+    return parser.close()
+
+
+def load(path_or_file: Union[str, bytes, os.PathLike, Iterable[Union[str, bytes]]], strict: bool = False,
+         type_conversion: bool = True, schema: Optional[Dict[str, Any]] = None,
+         compact: bool = False) -> Dict[str, Any]:
+    """
+    Parse a TAML file into a Python dictionary
+    
+    A path is memory-mapped and decoded in blocks of about 1 MiB, so neither the
+    whole text nor a list of its lines is held in memory while the document is
+    built.
+    
+    Args:
+        path_or_file: Path of a UTF-8 file, or an open text or binary file
+        strict: Enable strict parsing (default: False)
+        type_conversion: Convert string values to native types (default: True)
+        schema: Value types for dotted key paths, as for parse()
+        compact: Return collections of records, as for parse()
     
     Returns:
         Parsed Python dictionary
@@ -49,180 +101,647 @@ def parse(text: str, strict: bool = False, type_conversion: bool = True) -> Dict
     Raises:
         TAMLError: If parsing fails in strict mode
     """
-    lines = text.split('\n')
-    root: Dict[str, Any] = {}
-    stack: List[Dict[str, Any]] = [{'level': -1, 'node': root}]
-    skip_to: int = -1
-    
-    for i, line in enumerate(lines):
-        if i < skip_to:
-            continue
+    parser = _Parser(strict, type_conversion, schema, compact=compact)
+    feed = parser.feed
+    if isinstance(path_or_file, (str, bytes, os.PathLike)):
+        with open(path_or_file, 'rb') as f:
+            if os.fstat(f.fileno()).st_size == 0:
+                return parser.close()
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                # Decode blocks that end at a line break
+                size = len(mapped)
+                start = 0
+                while start < size:
+                    end = size
+                    if start + _LOAD_BLOCK_SIZE < size:
+                        end = mapped.rfind(b'\n', start, start + _LOAD_BLOCK_SIZE)
+                        if end == -1:
+                            end = mapped.find(b'\n', start + _LOAD_BLOCK_SIZE)
+                            if end == -1:
+                                end = size
+                    for line in mapped[start:end].decode('utf-8').split('\n'):
+                        feed(line)
+                    start = end + 1
+    else:
+        for line in _read_lines(path_or_file):
+            feed(line)
+    return parser.close()
+
+
+def iterparse(fileobj: Iterable[Union[str, bytes]], strict: bool = False,
+              type_conversion: bool = True,
+              schema: Optional[Dict[str, Any]] = None) -> Iterator[Tuple[str, Tuple[Union[str, int], ...], Any]]:
+    """
+    Parse TAML from a file-like object, yielding events as lines are read
+    
+    Events are ``(event, path, value)`` tuples, where path is a tuple of keys
+    and list indexes from the root:
+    
+    - ``('start_map', path, None)`` / ``('end_map', path, None)``
+    - ``('start_list', path, None)`` / ``('end_list', path, None)``
+    - ``('value', path, value)`` for key-value pairs, raw text and list items
+    
+    A repeated bare key starts a new map at the same path each time; parse()
+    gathers the repeats into a list. Values are not kept after they are
+    yielded, so memory is bounded by the keys of the open containers.
+    
+    Args:
+        fileobj: Text or binary (UTF-8) file, or any iterable of lines
+        strict: Enable strict parsing (default: False)
+        type_conversion: Convert string values to native types (default: True)
+        schema: Value types for dotted key paths, as for parse()
+    
+    Yields:
+        Event tuples in document order
+    
+    Raises:
+        TAMLError: If parsing fails in strict mode
+    """
+    parser = _Parser(strict, type_conversion, schema, events=True)
+    events = parser.events
+    for line in _read_lines(fileobj):
+        parser.feed(line)
+        if events:
+            yield from events
+            events.clear()
+    parser.close()
+    yield from events
+
+
+def iter_records(fileobj: Iterable[Union[str, bytes]], key: str, strict: bool = False,
+                 type_conversion: bool = True,
+                 schema: Optional[Dict[str, Any]] = None) -> Iterator[Dict[str, Any]]:
+    """
+    Iterate over the dictionaries of a repeated bare key as each one completes
+    
+    Yielded records are not kept, so memory is bounded by the size of a record
+    and the rest of the document rather than the whole collection. A key that
+    appears only once is a plain nested dictionary, not a record, and is not
+    yielded. Records nested inside another record stay part of it.
+    
+    Args:
+        fileobj: Text or binary (UTF-8) file, or any iterable of lines
+        key: Repeated bare key of the records (e.g. ``user`` in ``users``/``user``/``user``)
+        strict: Enable strict parsing (default: False)
+        type_conversion: Convert string values to native types (default: True)
+        schema: Value types for dotted key paths, as for parse()
+    
+    Yields:
+        Record dictionaries as each one completes; the first object of a
+        collection is yielded once its key repeats
+    
+    Raises:
+        TAMLError: If parsing fails in strict mode
+    """
+    parser = _Parser(strict, type_conversion, schema, record_key=key)
+    records = parser.records
+    for line in _read_lines(fileobj):
+        parser.feed(line)
+        if records:
+            yield from records
+            records.clear()
+    parser.close()
+    yield from records
+
+
+def _read_lines(fileobj: Iterable[Union[str, bytes]]) -> Iterator[str]:
+    """Lines of a text or binary file without their line endings"""
+    for line in fileobj:
+        if isinstance(line, bytes):
+            line = line.decode('utf-8')
+        if line.endswith('\n'):
+            line = line[:-1]
+        yield line
+
+
+class _Parser:
+    """
+    Single-pass TAML parser
+    
+    Lines are fed in document order. Whether a new bare key holds a list or a
+    dict depends on its children, so every bare line opens a scope that is
+    decided as its children arrive: a key-value child or a repeated bare child
+    with children makes it a dict at once, otherwise it becomes a list when the
+    scope ends if it has a childless bare item. Lines that would need an
+    undecided scope are queued until it is decided, so each line is examined a
+    constant number of times, and the objects of a collection are built as
+    they are read.
+    
+    With ``events``, the parser appends iterparse() events to ``self.events``
+    and drops values once they are reported. With ``record_key``, the objects
+    of that repeated bare key are moved to ``self.records`` as they complete
+    instead of being added to the document.
+    
+    Keys are interned in a per-parse table, so the objects of a collection
+    share their key strings. With ``compact``, homogeneous collections are
+    turned into records when the document is closed.
+    """
+    
+    def __init__(self, strict: bool = False, type_conversion: bool = True,
+                 schema: Optional[Dict[str, Any]] = None,
+                 events: bool = False, record_key: Optional[str] = None, compact: bool = False):
+        self.strict = strict
+        self.type_conversion = type_conversion
+        self.compact = compact
+        self.root: Dict[str, Any] = {}
+        # load_as() passes a schema it has already compiled
+        root_schema = schema if isinstance(schema, _SchemaNode) else _compile_schema(schema) if schema else None
+        self.events: Optional[List[Tuple[str, Tuple[Union[str, int], ...], Any]]] = [] if events else None
+        self.record_key = record_key
+        self.records: List[Dict[str, Any]] = []
+        # Level of the record being built, if any
+        self.record_level: Optional[int] = None
+        self.streaming = events or record_key is not None
+        # Stack entries are (level, node, schema node); streaming entries are
+        # [level, node, schema node, path, list item count, is a record]
+        self.stack: List[Any] = [
+            [-1, self.root, root_schema, (), 0, False] if self.streaming else (-1, self.root, root_schema)
+        ]
+        self.line_num = 0
+        # Lines fed but not built yet: (line number, line, level, bare)
+        self.queue: Deque[Tuple[int, str, int, Optional[bool]]] = deque()
+        # Open scopes of bare lines:
+        # [level, line number, has list items, decided as a dict, bare children with children]
+        self.scopes: List[List[Any]] = []
+        # Scope whose latest direct child is bare, and that child's key;
+        # the next line tells if that child has children
+        self.pending: Optional[List[Any]] = None
+        self.pending_key = ''
+        # Decided bare lines: line number -> is a list
+        self.kinds: Dict[int, bool] = {}
+        # Raw text being collected: [parent stack entry or None, key, base indent, lines]
+        self.raw: Optional[List[Any]] = None
+        # Interned dictionary keys
+        self.keys: Dict[str, str] = {}
+    
+    def feed(self, line: str) -> None:
+        """Add the next line of the document"""
+        self.line_num += 1
+        line_num = self.line_num
         
-        line_num = i + 1
+        stripped = line.strip()
+        if not stripped:
+            level = -1
+            bare = None
+        else:
+            level = len(line) - len(line.lstrip(TAB))
+            if stripped[0] == '#':
+                bare = None
+            else:
+                bare = line.find(TAB, level) == -1
+                self._scan(line_num, level, bare, line[level:].rstrip() if bare else '')
         
-        # Skip empty lines
-        if not line.strip():
-            continue
+        if self.queue or bare:
+            self.queue.append((line_num, line, level, bare))
+            self._drain()
+        else:
+            self._build(line_num, line, level, bare, False)
+    
+    def close(self) -> Dict[str, Any]:
+        """Finish the document and return the parsed dictionary"""
+        if self.pending is not None:
+            self.pending[2] = True
+            self.pending = None
+        while self.scopes:
+            self._decide(self.scopes.pop())
+        self._drain()
+        if self.raw is not None:
+            self._end_raw()
+        self._pop_to(0)
+        if self.compact:
+            compact_collections(self.root)
+        return self.root
+    
+    def _scan(self, line_num: int, level: int, bare: bool, key: str) -> None:
+        """Update the open scopes with a significant line"""
+        scopes = self.scopes
+        pending = self.pending
+        if pending is not None:
+            self.pending = None
+            # The previous bare child has children only if this line is deeper
+            if level <= pending[0] + 1:
+                pending[2] = True
+            elif not pending[3]:
+                names = pending[4]
+                if names is None:
+                    pending[4] = {self.pending_key}
+                elif self.pending_key in names:
+                    # A repeated bare key with children settles a collection
+                    pending[3] = True
+                    pending[4] = None
+                    self.kinds[pending[1]] = False
+                else:
+                    names.add(self.pending_key)
         
-        # Skip comments
-        if line.lstrip().startswith('#'):
-            continue
+        while scopes and scopes[-1][0] >= level:
+            self._decide(scopes.pop())
         
-        # Check for space indentation
-        if line and line[0] == ' ':
-            if strict:
-                raise TAMLError('Indentation must use tabs, not spaces', line_num)
-            continue
+        if scopes and scopes[-1][0] == level - 1:
+            scope = scopes[-1]
+            if bare:
+                self.pending = scope
+                self.pending_key = key
+            elif not scope[3]:
+                # A key-value child settles it as a dict
+                scope[3] = True
+                scope[4] = None
+                self.kinds[scope[1]] = False
         
-        # Count leading tabs
-        level = 0
-        for char in line:
-            if char == '\t':
-                level += 1
-            elif char == ' ':
-                if strict:
-                    raise TAMLError('Mixed spaces and tabs in indentation', line_num)
-                break
+        if bare:
+            scopes.append([level, line_num, False, False, None])
+    
+    def _intern(self, key: str) -> str:
+        keys = self.keys
+        interned = keys.get(key)
+        if interned is not None:
+            return interned
+        if len(keys) < _MAX_INTERNED_KEYS:
+            keys[key] = key
+        return key
+    
+    def _decide(self, scope: List[Any]) -> None:
+        if not scope[3]:
+            self.kinds[scope[1]] = scope[2]
+    
+    def _drain(self) -> None:
+        """Build queued lines up to the first one still waiting on its scope"""
+        queue = self.queue
+        kinds = self.kinds
+        while queue:
+            line_num, line, level, bare = queue[0]
+            if bare:
+                if line_num not in kinds:
+                    return
+                is_array = kinds.pop(line_num)
             else:
-                break
+                is_array = False
+            queue.popleft()
+            self._build(line_num, line, level, bare, is_array)
+    
+    def _end_raw(self) -> None:
+        entry, key, _, raw_lines = self.raw
+        self.raw = None
+        # Remove trailing empty lines
+        while raw_lines and raw_lines[-1] == '':
+            raw_lines.pop()
+        if entry is None:
+            return
+        if self.events is not None:
+            self._value(entry, key, '\n'.join(raw_lines))
+        else:
+            entry[1][key] = '\n'.join(raw_lines)
+    
+    def _pop_to(self, level: int) -> None:
+        """Close the containers at or below level"""
+        stack = self.stack
+        while len(stack) > 1 and stack[-1][0] >= level:
+            entry = stack.pop()
+            if self.streaming:
+                self._close(entry)
+    
+    def _push(self, entry: List[Any], key: str, level: int, node: Any, schema: Optional['_SchemaNode'],
+              record: bool) -> None:
+        """Open a container under a streaming stack entry"""
+        path = entry[3] + (key,)
+        self.stack.append([level, node, schema, path, 0, record])
+        if self.events is not None:
+            self.events.append(('start_list' if isinstance(node, list) else 'start_map', path, None))
+    
+    def _close(self, entry: List[Any]) -> None:
+        node = entry[1]
+        if self.events is not None:
+            self.events.append(('end_list' if isinstance(node, list) else 'end_map', entry[3], None))
+            # Only the container's type is needed from now on
+            node.clear()
+        if entry[5]:
+            self.records.append(node)
+            self.record_level = None
+    
+    def _value(self, entry: List[Any], key: str, value: Any) -> None:
+        entry[1][key] = None
+        self.events.append(('value', entry[3] + (key,), value))
+    
+    def _item(self, entry: List[Any], key: str) -> None:
+        index = entry[4]
+        entry[4] = index + 1
+        self.events.append(('value', entry[3] + (index,), key))
+    
+    def _repeat(self, entry: List[Any], key: str, level: int, existing: Any,
+                schema: Optional['_SchemaNode']) -> None:
+        """Start another object of a repeated bare key while streaming"""
+        parent_node = entry[1]
+        new_dict: Dict[str, Any] = {}
+        record = key == self.record_key and self.record_level is None
+        if record or self.events is not None:
+            if record and isinstance(existing, dict):
+                # The first object only turns out to be a record now
+                self.records.append(existing)
+            # The placeholder keeps later repeats in the collection
+            parent_node[key] = [{}]
+            if record:
+                self.record_level = level
+        elif isinstance(existing, dict):
+            parent_node[key] = [existing, new_dict]
+        else:
+            existing.append(new_dict)
+        self._push(entry, key, level, new_dict, schema, record)
+    
+    def _build(self, line_num: int, line: str, level: int, bare: Optional[bool], is_array: bool) -> None:
+        """Add one line to the document; is_array is the decided kind of a bare line"""
+        strict = self.strict
         
-        content = line[level:]
+        raw = self.raw
+        if raw is not None:
+            # Blank lines are preserved; raw text ends when indentation drops below its base
+            if level < 0:
+                raw[3].append('')
+                return
+            if level >= raw[2]:
+                raw[3].append(line[raw[2]:])
+                return
+            self._end_raw()
         
-        if not content.strip():
-            continue
+        # Skip empty lines and comments
+        if bare is None:
+            return
         
-        # Check for key-value separator
-        tab_index = content.find(TAB)
-        has_value = tab_index != -1
+        # Check for space indentation
+        if line[0] == ' ':
+            if strict:
+                raise TAMLError('Indentation must use tabs, not spaces', line_num)
+            return
         
-        if has_value:
-            key = content[:tab_index]
-            # Skip all separator tabs
-            value_start = tab_index
-            while value_start < len(content) and content[value_start] == TAB:
-                value_start += 1
-            raw_value = content[value_start:].rstrip() if value_start < len(content) else ''
-        else:
-            key = content.rstrip()
+        if strict and line[level] == ' ':
+            raise TAMLError('Mixed spaces and tabs in indentation', line_num)
+        
+        # Check for key-value separator
+        if bare:
+            key = line[level:].rstrip()
             raw_value = None
+        else:
+            tab_index = line.find(TAB, level)
+            key = line[level:tab_index]
+            # Skip all separator tabs
+            raw_value = line[tab_index:].lstrip(TAB).rstrip()
         
-        if not key:
-            if strict:
-                raise TAMLError('Line has no key', line_num)
-            continue
+        stack = self.stack
         
         # Handle raw text blocks
         if raw_value == RAW_TEXT_MARKER:
-            while len(stack) > 1 and stack[-1]['level'] >= level:
-                stack.pop()
+            if len(stack) > 1 and stack[-1][0] >= level:
+                self._pop_to(level)
             
-            parent = stack[-1]
-            if level > parent['level'] + 1:
+            entry = stack[-1]
+            if level > entry[0] + 1:
                 if strict:
                     raise TAMLError(
-                        f"Invalid indentation level (expected {parent['level'] + 1} tabs, found {level})",
+                        f"Invalid indentation level (expected {entry[0] + 1} tabs, found {level})",
                         line_num
                     )
-                continue
+                return
             
-            parent_node = parent['node']
-            raw_content, skip_to = _collect_raw_text(lines, i, level)
-            if isinstance(parent_node, dict):
-                parent_node[key] = raw_content
-            continue
+            self.raw = [entry if isinstance(entry[1], dict) else None, key, level + 1, []]
+            return
         
         # Check for tabs in value
         if raw_value and TAB in raw_value:
             if strict:
                 raise TAMLError('Value contains invalid tab character', line_num)
-            continue
-        
-        # Convert value
-        value: Any
-        if raw_value == NULL_VALUE:
-            value = None
-        elif raw_value == EMPTY_STRING:
-            value = ''
-        elif raw_value is not None and raw_value != '' and type_conversion:
-            value = _convert_type(raw_value)
-        else:
-            value = raw_value
+            return
         
         # Pop stack to correct level
-        while len(stack) > 1 and stack[-1]['level'] >= level:
-            stack.pop()
+        if len(stack) > 1 and stack[-1][0] >= level:
+            self._pop_to(level)
         
-        parent = stack[-1]
+        entry = stack[-1]
+        parent_level = entry[0]
+        parent_node = entry[1]
         
         # Check indentation level
-        if level > parent['level'] + 1:
+        if level > parent_level + 1:
             if strict:
                 raise TAMLError(
-                    f"Invalid indentation level (expected {parent['level'] + 1} tabs, found {level})",
+                    f"Invalid indentation level (expected {parent_level + 1} tabs, found {level})",
                     line_num
                 )
-            continue
+            return
         
-        parent_node = parent['node']
+        schema = entry[2]
+        if schema is not None:
+            schema = schema.child(key)
         
+        events = self.events
         if isinstance(parent_node, list):
             # Parent is a list, this is a list item
-            if has_value:
+            if not bare:
                 if strict:
                     raise TAMLError('List items cannot be key-value pairs', line_num)
-                continue
-            parent_node.append(key)
-        else:
-            # Parent is a dict
-            if has_value:
-                # Leaf value
-                parent_node[key] = value
+                return
+            if events is not None:
+                self._item(entry, key)
             else:
+                parent_node.append(key)
+        elif not bare:
+            key = self._intern(key)
+            
+            # Convert value
+            value: Any
+            if raw_value == NULL_VALUE:
+                value = None
+            elif raw_value == EMPTY_STRING:
+                value = ''
+            elif schema is not None and schema.convert is not None:
+                try:
+                    value = schema.convert(raw_value)
+                except ValueError:
+                    if strict:
+                        raise TAMLError(f'Value "{raw_value}" is not a valid {schema.type}', line_num)
+                    value = raw_value
+            elif raw_value and self.type_conversion:
+                value = _convert_type(raw_value)
+            else:
+                value = raw_value
+            
+            # Leaf value
+            if events is not None:
+                self._value(entry, key, value)
+            else:
+                parent_node[key] = value
+        else:
+            key = self._intern(key)
+            existing = parent_node.get(key)
+            if isinstance(existing, dict) or (
+                    isinstance(existing, list) and existing and isinstance(existing[0], dict)):
                 # Duplicate bare key → collection of objects
-                if key in parent_node and isinstance(parent_node[key], dict):
-                    existing = parent_node[key]
+                if self.streaming:
+                    self._repeat(entry, key, level, existing, schema)
+                elif isinstance(existing, dict):
                     new_dict: Dict[str, Any] = {}
                     parent_node[key] = [existing, new_dict]
-                    stack.append({'level': level, 'node': new_dict})
-                elif (key in parent_node
-                      and isinstance(parent_node[key], list)
-                      and parent_node[key]
-                      and isinstance(parent_node[key][0], dict)):
+                    stack.append((level, new_dict, schema))
+                else:
                     new_dict = {}
-                    parent_node[key].append(new_dict)
-                    stack.append({'level': level, 'node': new_dict})
+                    existing.append(new_dict)
+                    stack.append((level, new_dict, schema))
+            else:
+                # New key - its scope decided whether it is a list or dict
+                node: Any = [] if is_array else {}
+                parent_node[key] = node
+                if self.streaming:
+                    self._push(entry, key, level, node, schema, False)
                 else:
-                    # New key - determine if it's a list or dict
-                    is_array = _is_array_parent(lines, i, level)
-                    parent_node[key] = [] if is_array else {}
-                    stack.append({'level': level, 'node': parent_node[key]})
+                    stack.append((level, node, schema))
+
+
+def _to_number(value: str) -> Union[int, float]:
+    if value.lstrip('-').isdigit():
+        return int(value)
+    return float(value)
+
+
+def _to_integer(value: str) -> int:
+    if not _INTEGER_RE.match(value):
+        raise ValueError(value)
+    return int(value)
+
+
+def _to_boolean(value: str) -> bool:
+    lower = value.lower()
+    if lower in _TRUTHY_VALUES:
+        return True
+    if lower in _FALSY_VALUES:
+        return False
+    raise ValueError(value)
+
+
+def _to_date(value: str) -> Union[date, datetime]:
+    result = _try_parse_date(value)
+    if result is None:
+        raise ValueError(value)
+    return result
+
+
+def _to_auto(value: str) -> Any:
+    return _convert_type(value) if value else value
+
+
+# Schema value types; each converts the value text or raises ValueError
+_SCHEMA_TYPES: Dict[str, Callable[[str], Any]] = {
+    'auto': _to_auto,
+    'string': str,
+    'number': _to_number,
+    'integer': _to_integer,
+    'boolean': _to_boolean,
+    'date': _to_date,
+}
+
+
+class _SchemaNode:
+    """One key path segment of a compiled schema"""
+    
+    __slots__ = ('children', 'any', 'type', 'convert')
     
+    def __init__(self):
+        self.children: Dict[str, '_SchemaNode'] = {}
+        self.any: Optional['_SchemaNode'] = None
+        self.type: Optional[str] = None
+        self.convert: Optional[Callable[[str], Any]] = None
+    
+    def child(self, key: str) -> Optional['_SchemaNode']:
+        """Node for a key: the named child, otherwise the '*' child"""
+        return self.children.get(key, self.any)
+    
+    def merge(self, source: '_SchemaNode') -> None:
+        """Add the paths of source that this node doesn't set itself"""
+        if self.convert is None:
+            self.type = source.type
+            self.convert = source.convert
+        for key, child in source.children.items():
+            self.children.setdefault(key, _SchemaNode()).merge(child)
+        if source.any is not None:
+            if self.any is None:
+                self.any = _SchemaNode()
+            self.any.merge(source.any)
+
+
+def _compile_schema(schema: Dict[str, Any]) -> _SchemaNode:
+    """
+    Compile a schema of dotted key paths into a tree of key path segments
+    
+    Paths follow the keys in the document, so the objects of a collection are
+    reached through the repeated key (``users.user.id``). ``*`` paths are
+    copied into their named siblings, so a lookup only tries the named key
+    and then ``*``.
+    """
+    root = _SchemaNode()
+    for path, type_ in schema.items():
+        node = root
+        for key in path.split('.'):
+            if key == '*':
+                if node.any is None:
+                    node.any = _SchemaNode()
+                node = node.any
+            else:
+                node = node.children.setdefault(key, _SchemaNode())
+        if callable(type_):
+            node.type = getattr(type_, '__name__', 'value')
+            node.convert = type_
+        elif type_ in _SCHEMA_TYPES:
+            node.type = type_
+            node.convert = _SCHEMA_TYPES[type_]
+        else:
+            raise ValueError(f'Unknown schema type "{type_}" for "{path}"')
+    
+    pending = [root]
+    while pending:
+        node = pending.pop()
+        for child in node.children.values():
+            if node.any is not None:
+                child.merge(node.any)
+            pending.append(child)
+        if node.any is not None:
+            pending.append(node.any)
     return root
 
 
+@lru_cache(maxsize=4096)
 def _convert_type(value: str) -> Union[str, int, float, bool, date, datetime]:
     """
     Convert string value to native Python type
     
     Detection order: booleans → dates → numbers → strings
     
+    The first character decides which of these are possible, so most plain
+    strings are returned after one or two checks. Results are cached, since
+    literals like ``true`` or a date repeat a lot in large documents.
+    
     Args:
         value: String value to convert
     
     Returns:
         Converted value as the appropriate Python type
     """
-    # Booleans (case-insensitive)
-    lower = value.lower()
-    if lower in _TRUTHY_VALUES:
-        return True
-    if lower in _FALSY_VALUES:
-        return False
+    first = value[0]
+    if not first.isalpha():
+        return _convert_other(value)
     
-    # ISO 8601 dates/times
-    date_result = _try_parse_date(value)
-    if date_result is not None:
-        return date_result
+    # Only a boolean can start with a letter; all of them are ASCII
+    if len(value) <= 5 and first in _BOOLEAN_FIRST:
+        lower = value.lower()
+        if lower in _TRUTHY_VALUES:
+            return True
+        if lower in _FALSY_VALUES:
+            return False
+    return value
+
+
+def _convert_other(value: str) -> Union[str, int, float, date, datetime]:
+    """Convert a value that doesn't start with a letter"""
+    # ISO 8601 dates/times all start with a four digit year
+    if len(value) >= 7 and value[4] == '-' and value[:4].isdecimal():
+        date_result = _try_parse_date(value)
+        if date_result is not None:
+            return date_result
     
     # Try integer
     if value.lstrip('-').isdigit():
@@ -273,115 +792,3 @@ def _try_parse_date(value: str) -> Optional[Union[date, datetime]]:
             return None
     
     return None
-
-
-def _collect_raw_text(lines: List[str], current_index: int, parent_level: int) -> Tuple[str, int]:
-    """
-    Collect raw text content from lines following a ... indicator
-    
-    Args:
-        lines: All document lines
-        current_index: Index of the line containing the ... value
-        parent_level: Indentation level of the parent key
-    
-    Returns:
-        Tuple of (raw text content string, next line index to process)
-    """
-    base_indent = parent_level + 1
-    raw_lines: List[str] = []
-    j = current_index + 1
-    
-    while j < len(lines):
-        raw_line = lines[j]
-        
-        # Blank/empty lines are preserved as empty content lines
-        if not raw_line.strip():
-            raw_lines.append('')
-            j += 1
-            continue
-        
-        # Count indentation
-        indent = 0
-        for ch in raw_line:
-            if ch == '\t':
-                indent += 1
-            else:
-                break
-        
-        # End raw text if indentation drops below required level
-        if indent < base_indent:
-            break
-        
-        # Strip structural indentation, preserve remaining content
-        raw_lines.append(raw_line[base_indent:])
-        j += 1
-    
-    # Remove trailing empty lines
-    while raw_lines and raw_lines[-1] == '':
-        raw_lines.pop()
-    
-    return '\n'.join(raw_lines), j
-
-
-def _is_array_parent(lines: List[str], current_index: int, level: int) -> bool:
-    """Determine if a parent node should be an array or dict"""
-    has_list_items = False
-    has_key_value_pairs = False
-    
-    for j in range(current_index + 1, len(lines)):
-        next_line = lines[j]
-        
-        if not next_line.strip() or next_line.lstrip().startswith('#'):
-            continue
-        
-        # Count indentation
-        next_indent = 0
-        for char in next_line:
-            if char == '\t':
-                next_indent += 1
-            else:
-                break
-        
-        # Stop if back to same or lower level
-        if next_indent < level + 1:
-            break
-        
-        # Only check immediate children
-        if next_indent == level + 1:
-            next_content = next_line[next_indent:]
-            next_tab_idx = next_content.find(TAB)
-            
-            if next_tab_idx > 0:
-                # Has key-value with tab separator
-                has_key_value_pairs = True
-            elif next_tab_idx == -1:
-                # No tab - could be list item or parent node
-                # Check if it has children
-                has_children = _has_children(lines, j, next_indent)
-                if not has_children:
-                    has_list_items = True
-    
-    return has_list_items and not has_key_value_pairs
-
-
-def _has_children(lines: List[str], current_index: int, level: int) -> bool:
-    """Check if a line has children"""
-    for k in range(current_index + 1, len(lines)):
-        check_line = lines[k]
-        
-        if not check_line.strip() or check_line.lstrip().startswith('#'):
-            continue
-        
-        check_indent = 0
-        for char in check_line:
-            if char == '\t':
-                check_indent += 1
-            else:
-                break
-        
-        if check_indent > level:
-            return True
-        elif check_indent <= level:
-            break
-    
-    return False
@@ -0,0 +1,86 @@
+"""TAML records - Compact objects for collections"""
+
+import keyword
+from collections.abc import Mapping
+from functools import lru_cache
+from typing import Any, Dict, Iterable, Iterator, List, Tuple
+
+
+class Record(Mapping):
+    """
+    Read-only mapping of one object in a collection, holding its values in a tuple
+    
+    Records of the same keys share a subclass that holds the keys, so each
+    record costs a slot and a tuple instead of a dict. Values are read with
+    ``record['key']`` or, for keys that are identifiers and don't clash with a
+    method, ``record.key``. Records compare equal to dicts with the same items;
+    ``_asdict()`` returns a dict.
+    """
+    
+    __slots__ = ('_values',)
+    _fields: Tuple[str, ...] = ()
+    _index: Dict[str, int] = {}
+    
+    def __init__(self, values: Iterable[Any]):
+        self._values = tuple(values)
+    
+    def __getitem__(self, key: str) -> Any:
+        return self._values[self._index[key]]
+    
+    def __iter__(self) -> Iterator[str]:
+        return iter(self._fields)
+    
+    def __len__(self) -> int:
+        return len(self._fields)
+    
+    def __contains__(self, key: object) -> bool:
+        return key in self._index
+    
+    def __repr__(self) -> str:
+        return f'Record({self._asdict()!r})'
+    
+    def __reduce__(self) -> Tuple[Any, ...]:
+        return _make_record, (self._fields, self._values)
+    
+    def _asdict(self) -> Dict[str, Any]:
+        return dict(zip(self._fields, self._values))
+
+
+@lru_cache(maxsize=1024)
+def _record_class(fields: Tuple[str, ...]) -> type:
+    """Record subclass for a sequence of keys"""
+    namespace: Dict[str, Any] = {
+        '__slots__': (),
+        '_fields': fields,
+        '_index': {key: index for index, key in enumerate(fields)},
+    }
+    for index, key in enumerate(fields):
+        if (key.isidentifier() and not keyword.iskeyword(key) and not key.startswith('_')
+                and not hasattr(Record, key)):
+            namespace[key] = property(lambda self, index=index: self._values[index])
+    return type('Record', (Record,), namespace)
+
+
+def _make_record(fields: Tuple[str, ...], values: Iterable[Any]) -> Record:
+    return _record_class(fields)(values)
+
+
+def compact_collections(root: Dict[str, Any]) -> None:
+    """Replace the objects of each collection whose objects all have the same keys with records, in place"""
+    collections: List[List[Any]] = []
+    pending: List[Any] = [root]
+    while pending:
+        node = pending.pop()
+        for child in node.values() if isinstance(node, dict) else node:
+            if isinstance(child, (dict, list)):
+                pending.append(child)
+        if isinstance(node, list) and node and isinstance(node[0], dict):
+            collections.append(node)
+    
+    # Nested collections come after the ones holding them, so they are compacted first
+    for items in reversed(collections):
+        fields = tuple(items[0])
+        if all(isinstance(item, dict) and len(item) == len(fields) and tuple(item) == fields for item in items):
+            make = _record_class(fields)
+            for index, item in enumerate(items):
+                items[index] = make(item.values())
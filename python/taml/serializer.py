@@ -1,13 +1,41 @@
 """TAML Serializer - Convert Python objects to TAML format"""
 
+import io
 from datetime import date, datetime
-from typing import Any, List
+from typing import IO, Any, Callable, Dict, List, Optional, Tuple
+
+from .record import Record
 
 TAB = '\t'
 NULL_VALUE = '~'
 EMPTY_STRING = '""'
 RAW_TEXT_MARKER = '...'
 
+_MAPPINGS = (dict, Record)
+
+
+# Characters stringify() buffers before each write to its StringIO
+_STRINGIFY_BATCH_SIZE = 1 << 16
+
+
+def _format_bool(value: bool) -> str:
+    return 'true' if value else 'false'
+
+
+def _format_none(value: None) -> str:
+    return NULL_VALUE
+
+
+# Text of scalar values by exact type; strings and other types take the general path
+_FORMATTERS: Dict[type, Callable[[Any], str]] = {
+    int: int.__repr__,
+    float: float.__repr__,
+    bool: _format_bool,
+    type(None): _format_none,
+    date: date.isoformat,
+    datetime: datetime.isoformat,
+}
+
 
 def stringify(obj: Any, indent_level: int = 0, type_conversion: bool = True) -> str:
     """
@@ -21,79 +49,201 @@ def stringify(obj: Any, indent_level: int = 0, type_conversion: bool = True) ->
     Returns:
         TAML formatted string
     """
-    lines: List[str] = []
-    _serialize_value(obj, lines, indent_level, type_conversion)
-    return '\n'.join(lines)
+    buffer = io.StringIO()
+    writer = _Writer(buffer, _STRINGIFY_BATCH_SIZE)
+    writer.value(obj, indent_level)
+    writer.flush()
+    return buffer.getvalue()
 
 
-def _serialize_value(value: Any, lines: List[str], level: int, type_conversion: bool) -> str:
-    """Serialize a value and return its string representation"""
-    if value is None:
-        return NULL_VALUE
-    
-    if value == '':
-        return EMPTY_STRING
+def dump(obj: Any, fileobj: IO, indent_level: int = 0, type_conversion: bool = True,
+         chunk_size: int = 65536) -> None:
+    """
+    Serialize a Python object to TAML and write it to a file
     
-    if isinstance(value, bool):
-        return 'true' if value else 'false'
+    Lines are written in chunks of about chunk_size characters as they are
+    produced, so the whole document is never held in memory. The output is the
+    same as stringify().
     
-    if isinstance(value, datetime):
-        return value.isoformat()
+    Args:
+        obj: Python object to serialize
+        fileobj: Text file, or binary file to write UTF-8 to
+        indent_level: Starting indentation level (default: 0)
+        type_conversion: Convert native types to strings (default: True)
+        chunk_size: Characters to buffer before each write (default: 65536)
+    """
+    writer = _Writer(fileobj, chunk_size)
+    writer.value(obj, indent_level)
+    writer.flush()
+
+
+class _Writer:
+    """
+    Serializes values line by line and writes the lines to a file in batches
     
-    if isinstance(value, date):
-        return value.isoformat()
+    Indentation strings are built once per level. A batch is joined and
+    written once it holds about batch_size characters, going by the average
+    length of the lines written so far. Objects of a collection that have the
+    same keys as the previous one reuse its indented key prefixes.
+    """
     
-    if isinstance(value, str):
-        return value
+    def __init__(self, fileobj: IO, batch_size: int):
+        self.write = fileobj.write
+        # Wrappers such as NamedTemporaryFile aren't io classes but have a mode
+        mode = getattr(fileobj, 'mode', None)
+        if isinstance(mode, str):
+            self.binary = 'b' in mode
+        else:
+            self.binary = not isinstance(fileobj, io.TextIOBase)
+        self.batch_size = batch_size
+        self.lines: List[str] = []
+        # Lines per batch, until the first batch gives their average length
+        self.batch_lines = max(1, batch_size // 32)
+        self.started = False
+        self.indents: List[str] = ['']
     
-    if isinstance(value, (int, float)):
-        return str(value)
+    def indent(self, level: int) -> str:
+        indents = self.indents
+        while len(indents) <= level:
+            indents.append(indents[-1] + TAB)
+        return indents[level]
     
-    if isinstance(value, (list, tuple)):
-        for item in value:
-            indent = TAB * level
-            if isinstance(item, dict):
-                _serialize_object(item, lines, level, type_conversion)
-            elif isinstance(item, (list, tuple)):
-                _serialize_value(item, lines, level, type_conversion)
-            else:
-                serialized = _serialize_value(item, [], level, type_conversion)
-                lines.append(indent + serialized)
-        return ''
+    def flush(self) -> None:
+        lines = self.lines
+        if not lines:
+            return
+        chunk = '\n'.join(lines)
+        self.batch_lines = max(1, self.batch_size * len(lines) // (len(chunk) + 1))
+        if self.started:
+            chunk = '\n' + chunk
+        self.started = True
+        lines.clear()
+        self.write(chunk.encode('utf-8') if self.binary else chunk)
     
-    if isinstance(value, dict):
-        _serialize_object(value, lines, level, type_conversion)
-        return ''
+    def value(self, value: Any, level: int) -> None:
+        """Write a top-level value; scalars have no lines of their own"""
+        if isinstance(value, _MAPPINGS):
+            self.object(value, level)
+        elif isinstance(value, (list, tuple)):
+            self.items(value, level)
     
-    return str(value)
-
-
-def _serialize_object(obj: dict, lines: List[str], level: int, type_conversion: bool) -> None:
-    """Serialize a dictionary object"""
-    indent = TAB * level
+    def object(self, obj: Any, level: int) -> None:
+        """Write the entries of a dictionary or record"""
+        lines = self.lines
+        append = lines.append
+        formatters = _FORMATTERS
+        indent = self.indent(level)
+        entries = zip(obj._fields, obj._values) if isinstance(obj, Record) else obj.items()
+        for key, value in entries:
+            cls = value.__class__
+            if cls is str:
+                if value and '\n' not in value and TAB not in value:
+                    append(f'{indent}{key}\t{value}')
+                else:
+                    self.entry(indent, key, value, level)
+            elif cls in formatters:
+                append(f'{indent}{key}\t{formatters[cls](value)}')
+            elif isinstance(value, _MAPPINGS):
+                append(f'{indent}{key}')
+                self.object(value, level + 1)
+            else:
+                self.entry(indent, key, value, level)
+            if len(lines) >= self.batch_lines:
+                self.flush()
     
-    for key, value in obj.items():
+    def entry(self, indent: str, key: Any, value: Any, level: int) -> None:
+        """Write a dictionary entry that isn't a plain scalar"""
+        append = self.lines.append
         if value is None:
-            lines.append(indent + key + TAB + NULL_VALUE)
+            append(f'{indent}{key}\t{NULL_VALUE}')
         elif value == '':
-            lines.append(indent + key + TAB + EMPTY_STRING)
-        elif isinstance(value, str) and ('\n' in value or '\t' in value):
+            append(f'{indent}{key}\t{EMPTY_STRING}')
+        elif isinstance(value, str) and ('\n' in value or TAB in value):
             # Raw text block for strings containing newlines or tabs
-            lines.append(indent + key + TAB + RAW_TEXT_MARKER)
+            append(f'{indent}{key}\t{RAW_TEXT_MARKER}')
+            raw_indent = self.indent(level + 1)
             for raw_line in value.split('\n'):
-                lines.append(indent + TAB + raw_line)
-        elif isinstance(value, dict):
-            lines.append(indent + key)
-            _serialize_object(value, lines, level + 1, type_conversion)
+                append(raw_indent + raw_line)
+        elif isinstance(value, _MAPPINGS):
+            append(f'{indent}{key}')
+            self.object(value, level + 1)
         elif isinstance(value, (list, tuple)):
-            if value and all(isinstance(item, dict) for item in value):
+            if value and all(isinstance(item, _MAPPINGS) for item in value):
                 # Collection of objects → repeated parent keys
-                for item in value:
-                    lines.append(indent + key)
-                    _serialize_object(item, lines, level + 1, type_conversion)
+                self.collection(f'{indent}{key}', value, level + 1)
             else:
-                lines.append(indent + key)
-                _serialize_value(value, lines, level + 1, type_conversion)
+                append(f'{indent}{key}')
+                self.items(value, level + 1)
         else:
-            serialized = _serialize_value(value, [], level, type_conversion)
-            lines.append(indent + key + TAB + serialized)
+            append(f'{indent}{key}\t{_format_scalar(value)}')
+    
+    def collection(self, head: str, items: Any, level: int) -> None:
+        """Write the objects of a collection, each under a repeat of its key line"""
+        lines = self.lines
+        append = lines.append
+        formatters = _FORMATTERS
+        indent = self.indent(level)
+        fields: Optional[Tuple[Any, ...]] = None
+        prefixes: List[str] = []
+        for item in items:
+            append(head)
+            if isinstance(item, Record):
+                keys = item._fields
+                values = item._values
+            else:
+                keys = tuple(item)
+                values = item.values()
+            if keys != fields:
+                fields = keys
+                prefixes = [f'{indent}{key}\t' for key in keys]
+            for prefix, key, value in zip(prefixes, keys, values):
+                cls = value.__class__
+                if cls is str:
+                    if value and '\n' not in value and TAB not in value:
+                        append(prefix + value)
+                    else:
+                        self.entry(indent, key, value, level)
+                elif cls in formatters:
+                    append(prefix + formatters[cls](value))
+                elif isinstance(value, _MAPPINGS):
+                    append(prefix[:-1])
+                    self.object(value, level + 1)
+                else:
+                    self.entry(indent, key, value, level)
+            if len(lines) >= self.batch_lines:
+                self.flush()
+    
+    def items(self, items: Any, level: int) -> None:
+        """Write list items"""
+        lines = self.lines
+        append = lines.append
+        indent = self.indent(level)
+        for item in items:
+            if isinstance(item, _MAPPINGS):
+                self.object(item, level)
+            elif isinstance(item, (list, tuple)):
+                self.items(item, level)
+            else:
+                append(indent + _format_scalar(item))
+                if len(lines) >= self.batch_lines:
+                    self.flush()
+
+
+def _format_scalar(value: Any) -> str:
+    """Text of a scalar value"""
+    if value is None:
+        return NULL_VALUE
+    
+    if value == '':
+        return EMPTY_STRING
+    
+    if isinstance(value, bool):
+        return 'true' if value else 'false'
+    
+    if isinstance(value, date):
+        return value.isoformat()
+    
+    if isinstance(value, str):
+        return value
+    
+    return str(value)
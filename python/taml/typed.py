@@ -0,0 +1,268 @@
+"""TAML typed loading - Parse TAML into dataclasses, NamedTuples and TypedDicts"""
+
+import dataclasses
+import enum
+from datetime import date, datetime
+from typing import Any, Callable, Dict, List, Optional, Tuple, Type, TypeVar, Union, get_type_hints
+
+from .parser import (
+    TAMLError, parse, load, _SchemaNode, _to_integer, _to_boolean, _to_date
+)
+
+T = TypeVar('T')
+
+# Builds the final value of a field from its parsed value
+Builder = Callable[[Any, bool], Any]
+
+# Class attribute holding a class's plan. A plan refers to its class, so it is
+# kept on the class rather than in a cache that would keep the class alive.
+_PLAN_ATTRIBUTE = '_taml_plan'
+
+
+def load_as(cls: Type[T], source: Any, strict: bool = False) -> T:
+    """
+    Parse TAML into an instance of a dataclass, NamedTuple or TypedDict
+    
+    Fields are read from the class's type hints. Values of typed fields are
+    converted straight from their text without type inference; nested
+    classes, lists, dicts, Optional and Enum fields are supported, and
+    fields typed Any are inferred as by parse(). The plan for each class is
+    computed once and cached.
+    
+    Args:
+        cls: Dataclass, NamedTuple or TypedDict class of the document
+        source: TAML text, or a path or file as for load()
+        strict: Enable strict parsing; values that don't match their field
+            type and keys that aren't fields are errors (default: False)
+    
+    Returns:
+        Instance of cls
+    
+    Raises:
+        TAMLError: If parsing fails in strict mode, or a required field is missing
+        TypeError: If cls is not a dataclass, NamedTuple or TypedDict
+    """
+    plan = _plan_for(cls)
+    if isinstance(source, str):
+        data = parse(source, strict=strict, schema=plan.schema)
+    else:
+        data = load(source, strict=strict, schema=plan.schema)
+    return plan.build(data, strict)
+
+
+class _Plan:
+    """How to build one class: its fields, their builders and the schema of its keys"""
+    
+    def __init__(self, cls: type):
+        self.cls = cls
+        self.schema = _SchemaNode()
+        # (field name, builder or None)
+        self.fields: List[Tuple[str, Optional[Builder]]] = []
+        self.names: frozenset = frozenset()
+        self.required: frozenset = frozenset()
+        # Fields converted from value text: field name -> type name
+        self.scalars: Dict[str, str] = {}
+        # No field needs a builder, so a dictionary of known keys is passed as is
+        self.direct = False
+        self.make: Callable[..., Any] = cls
+    
+    def build(self, value: Any, strict: bool) -> Any:
+        """Instance of the class from its parsed dictionary, which is consumed"""
+        if not isinstance(value, dict):
+            raise TAMLError(f'Expected the fields of {self.cls.__name__}, found {type(value).__name__}')
+        
+        keys = value.keys()
+        if strict and self.scalars:
+            for name in self.scalars.keys() & keys:
+                if isinstance(value[name], (dict, list)):
+                    raise TAMLError(
+                        f'Field "{name}" of {self.cls.__name__} needs a {self.scalars[name]} value, found nested keys'
+                    )
+        if self.direct and keys <= self.names and self.required <= keys:
+            return self.make(**value)
+        
+        kwargs = {}
+        for name, builder in self.fields:
+            if name in value:
+                item = value.pop(name)
+                kwargs[name] = builder(item, strict) if builder is not None and item is not None else item
+            elif name in self.required:
+                raise TAMLError(f'Missing field "{name}" for {self.cls.__name__}')
+        
+        if value and strict:
+            raise TAMLError(f'Unknown field "{next(iter(value))}" for {self.cls.__name__}')
+        return self.make(**kwargs)
+
+
+def _plan_for(cls: type) -> _Plan:
+    # Read from the class itself, as a subclass needs a plan of its own
+    plan = getattr(cls, '__dict__', {}).get(_PLAN_ATTRIBUTE)
+    if plan is not None:
+        return plan
+    
+    if dataclasses.is_dataclass(cls) and isinstance(cls, type):
+        fields = [field for field in dataclasses.fields(cls) if field.init]
+        names = [field.name for field in fields]
+        required = [
+            field.name for field in fields
+            if field.default is dataclasses.MISSING and field.default_factory is dataclasses.MISSING
+        ]
+    elif isinstance(cls, type) and issubclass(cls, tuple) and hasattr(cls, '_fields'):
+        names = list(cls._fields)
+        required = [name for name in names if name not in cls._field_defaults]
+    elif isinstance(cls, type) and issubclass(cls, dict) and hasattr(cls, '__total__'):
+        names = list(get_type_hints(cls))
+        required = list(getattr(cls, '__required_keys__', names if cls.__total__ else ()))
+    else:
+        raise TypeError(f'load_as() needs a dataclass, NamedTuple or TypedDict, not {cls!r}')
+    
+    # Registered before the fields are planned, so recursive classes share it
+    plan = _Plan(cls)
+    setattr(cls, _PLAN_ATTRIBUTE, plan)
+    plan.required = frozenset(required)
+    if issubclass(cls, dict):
+        plan.make = dict
+    
+    hints = get_type_hints(cls)
+    for name in names:
+        schema, builder = _plan_type(hints.get(name, Any))
+        if schema is not None:
+            plan.schema.children[name] = schema
+            if schema.convert is not None:
+                plan.scalars[name] = schema.type
+        plan.fields.append((name, builder))
+    plan.names = frozenset(names)
+    plan.direct = all(builder is None for _, builder in plan.fields)
+    return plan
+
+
+def _plan_type(tp: Any) -> Tuple[Optional[_SchemaNode], Optional[Builder]]:
+    """
+    Schema node and builder for a type hint. The schema node converts the
+    value text while parsing; the builder turns the parsed value into the
+    final one. Either is None when nothing needs doing.
+    """
+    origin = getattr(tp, '__origin__', None)
+    args = getattr(tp, '__args__', None) or ()
+    
+    if origin is Union:
+        options = [arg for arg in args if arg is not type(None)]
+        # Optional[X]; None values are passed through by the builders
+        return _plan_type(options[0]) if len(options) == 1 else (None, None)
+    
+    if origin in (list, List) or tp is list:
+        item = args[0] if args else Any
+        item_schema, item_builder = _plan_type(item)
+        if item_schema is not None and item_schema.convert is not None:
+            # List items are bare keys, which the parser leaves as text
+            return None, _list_builder(_text_builder(item_schema), False)
+        # Items other than lists may come as a single dict
+        nested = item is list or getattr(item, '__origin__', None) in (list, List)
+        return item_schema, _list_builder(item_builder, not nested)
+    
+    if origin in (dict, Dict) or tp is dict:
+        if len(args) < 2:
+            return None, None
+        value_schema, value_builder = _plan_type(args[1])
+        schema = None
+        if value_schema is not None:
+            schema = _SchemaNode()
+            schema.any = value_schema
+        return schema, _dict_builder(value_builder)
+    
+    if isinstance(tp, type):
+        scalar = _SCALARS.get(tp)
+        if scalar is not None:
+            return _scalar_schema(*scalar), None
+        if issubclass(tp, enum.Enum):
+            return _scalar_schema(tp.__name__, _enum_converter(tp)), None
+        if (dataclasses.is_dataclass(tp) or hasattr(tp, '_fields')
+                or (issubclass(tp, dict) and hasattr(tp, '__total__'))):
+            plan = _plan_for(tp)
+            return plan.schema, plan.build
+    
+    # Any and other types are inferred as by parse()
+    return None, None
+
+
+def _scalar_schema(type_name: str, convert: Callable[[str], Any]) -> _SchemaNode:
+    node = _SchemaNode()
+    node.type = type_name
+    node.convert = convert
+    return node
+
+
+def _text_builder(schema: _SchemaNode) -> Builder:
+    convert = schema.convert
+    
+    def build(value: Any, strict: bool) -> Any:
+        if not isinstance(value, str):
+            return value
+        try:
+            return convert(value)
+        except ValueError:
+            if strict:
+                raise TAMLError(f'Value "{value}" is not a valid {schema.type}')
+            return value
+    return build
+
+
+def _list_builder(item_builder: Optional[Builder], records: bool) -> Builder:
+    """Builder of a list field; records tells if its items can be dicts"""
+    def build(value: Any, strict: bool) -> List[Any]:
+        if isinstance(value, dict):
+            # A bare key without children is an empty list
+            if not value:
+                return []
+            if strict and not records:
+                raise TAMLError(f'Expected a list, found nested keys "{next(iter(value))}"')
+        # A repeated bare key gives a list of dicts; a single one gives a dict
+        items = value if isinstance(value, list) else [value]
+        if item_builder is None:
+            return items
+        return [item_builder(item, strict) if item is not None else None for item in items]
+    return build
+
+
+def _dict_builder(value_builder: Optional[Builder]) -> Builder:
+    def build(value: Any, strict: bool) -> Dict[str, Any]:
+        if not isinstance(value, dict):
+            raise TAMLError(f'Expected a dictionary, found {type(value).__name__}')
+        if value_builder is None:
+            return value
+        return {key: value_builder(item, strict) if item is not None else None for key, item in value.items()}
+    return build
+
+
+def _enum_converter(cls: Type[enum.Enum]) -> Callable[[str], enum.Enum]:
+    """Enum member by value, or else by name"""
+    def convert(value: str) -> enum.Enum:
+        try:
+            return cls(value)
+        except ValueError:
+            if value in cls.__members__:
+                return cls.__members__[value]
+            raise
+    return convert
+
+
+def _to_float(value: str) -> float:
+    return float(value)
+
+
+def _to_datetime(value: str) -> datetime:
+    result = _to_date(value)
+    if not isinstance(result, datetime):
+        result = datetime(result.year, result.month, result.day)
+    return result
+
+
+# Types converted straight from the value text: type name and converter
+_SCALARS: Dict[type, Tuple[str, Callable[[str], Any]]] = {
+    str: ('string', str),
+    int: ('integer', _to_integer),
+    float: ('number', _to_float),
+    bool: ('boolean', _to_boolean),
+    date: ('date', _to_date),
+    datetime: ('datetime', _to_datetime),
+}
@@ -0,0 +1,152 @@
+"""Tests for TAML file loading and dumping"""
+
+import io
+import os
+import tempfile
+import unittest
+from taml import parse, stringify, load, load_many, dump, TAMLError
+
+
+class TestLoad(unittest.TestCase):
+    
+    def setUp(self):
+        handle, self.path = tempfile.mkstemp(suffix='.taml')
+        os.close(handle)
+    
+    def tearDown(self):
+        os.remove(self.path)
+    
+    def write(self, text):
+        with open(self.path, 'w', encoding='utf-8', newline='') as f:
+            f.write(text)
+    
+    def test_load_path(self):
+        """Test loading a memory-mapped file by path"""
+        text = "name\tcafé\nserver\n\tport\t8080\nnotes\t...\n\tline one\n\n\tline two\nitems\n\tfirst\n\tsecond\n"
+        self.write(text)
+        self.assertEqual(load(self.path), parse(text))
+    
+    def test_load_empty_file(self):
+        """Test loading an empty file"""
+        self.write('')
+        self.assertEqual(load(self.path), {})
+    
+    def test_load_file_object(self):
+        """Test loading from open text and binary files"""
+        text = "user\n\tname\tAlice\nuser\n\tname\tBob"
+        self.write(text)
+        with open(self.path, encoding='utf-8') as f:
+            self.assertEqual(load(f), parse(text))
+        with open(self.path, 'rb') as f:
+            self.assertEqual(load(f), parse(text))
+
+
+class TestLoadMany(unittest.TestCase):
+    
+    def setUp(self):
+        self.dir = tempfile.TemporaryDirectory()
+        self.paths = []
+        for i in range(40):
+            path = os.path.join(self.dir.name, f'{i}.taml')
+            with open(path, 'w', encoding='utf-8') as f:
+                f.write(f"id\t{i}\nname\tfile {i}\ntags\n\tfirst\n\tsecond")
+            self.paths.append(path)
+    
+    def tearDown(self):
+        self.dir.cleanup()
+    
+    def test_load_many_in_order(self):
+        """Test that files loaded by worker processes come back in order"""
+        expected = [load(path) for path in self.paths]
+        self.assertEqual(load_many(self.paths, workers=2, chunksize=3), expected)
+        self.assertEqual(load_many(self.paths, workers=1), expected)
+        self.assertEqual(load_many(self.paths[:3], workers=4), expected[:3])
+        self.assertEqual(load_many([]), [])
+    
+    def test_load_many_options(self):
+        """Test that parse options reach the workers"""
+        results = load_many(self.paths, workers=2, type_conversion=False, schema={'name': 'string'})
+        self.assertEqual(results[7], {'id': '7', 'name': 'file 7', 'tags': ['first', 'second']})
+    
+    def test_load_many_error(self):
+        """Test that a strict mode error in a worker is raised with its line"""
+        with open(self.paths[20], 'w', encoding='utf-8') as f:
+            f.write("id\t20\n  bad")
+        with self.assertRaises(TAMLError) as context:
+            load_many(self.paths, workers=2, strict=True)
+        self.assertEqual(context.exception.line, 2)
+        with self.assertRaises(ValueError):
+            load_many(self.paths, workers=0)
+    
+    def test_load_many_error_path(self):
+        """Test that an error names the file it came from and keeps the original"""
+        with open(self.paths[20], 'w', encoding='utf-8') as f:
+            f.write("id\t20\n  bad")
+        for workers in (1, 2):
+            with self.assertRaises(TAMLError) as context:
+                load_many(self.paths, workers=workers, strict=True)
+            self.assertTrue(str(context.exception).startswith(f'{self.paths[20]}: Line 2: '))
+            self.assertIsInstance(context.exception.__cause__, TAMLError)
+        
+        missing = os.path.join(self.dir.name, 'missing.taml')
+        with self.assertRaises(TAMLError) as context:
+            load_many(self.paths[:30] + [missing], workers=2)
+        self.assertTrue(str(context.exception).startswith(f'{missing}: '))
+        self.assertIsInstance(context.exception.__cause__, FileNotFoundError)
+
+
+class TestDump(unittest.TestCase):
+    
+    def setUp(self):
+        self.data = {
+            'application': 'MyApp',
+            'server': {'host': 'localhost', 'port': 8080},
+            'notes': 'line one\nline two',
+            'features': ['auth', 'logging'],
+            'users': [{'name': f'user{i}', 'active': i % 2 == 0} for i in range(50)]
+        }
+    
+    def test_dump_matches_stringify(self):
+        """Test dump writes the same text as stringify, in chunks"""
+        out = io.StringIO()
+        dump(self.data, out, chunk_size=64)
+        self.assertEqual(out.getvalue(), stringify(self.data))
+    
+    def test_dump_binary(self):
+        """Test dump encodes UTF-8 for binary files"""
+        out = io.BytesIO()
+        dump({'name': 'café'}, out)
+        self.assertEqual(out.getvalue(), 'name\tcafé'.encode('utf-8'))
+    
+    def test_dump_binary_file(self):
+        """Test dump encodes UTF-8 for files opened in binary mode"""
+        with tempfile.NamedTemporaryFile(suffix='.taml') as f:
+            dump({'name': 'café'}, f)
+            f.seek(0)
+            self.assertEqual(f.read(), 'name\tcafé'.encode('utf-8'))
+            with open(f.name, 'wb') as out:
+                dump({'port': 80}, out)
+            f.seek(0)
+            self.assertEqual(f.read(), b'port\t80')
+    
+    def test_dump_text_temporary_file(self):
+        """Test dump writes text to a temporary file opened in text mode"""
+        with tempfile.TemporaryFile('w+', encoding='utf-8') as f:
+            dump({'name': 'café'}, f)
+            f.seek(0)
+            self.assertEqual(f.read(), 'name\tcafé')
+    
+    def test_round_trip(self):
+        """Test dump then load returns the data"""
+        handle, path = tempfile.mkstemp(suffix='.taml')
+        os.close(handle)
+        try:
+            with open(path, 'w', encoding='utf-8') as f:
+                dump(self.data, f)
+            self.assertEqual(load(path), self.data)
+        finally:
+            os.remove(path)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -495,6 +495,23 @@ class TestDuplicateBareKeys(unittest.TestCase):
         taml = stringify(original)
         reparsed = parse(taml)
         self.assertEqual(reparsed['users'], original['users'])
+    
+    def test_serialize_collection_with_varying_keys(self):
+        """Test objects of a collection with different keys or key orders"""
+        data = {
+            'user': [
+                {'name': 'Alice', 'id': 1},
+                {'name': 'Bob', 'id': 2},
+                {'id': 3, 'name': 'Carol', 'notes': 'a\nb', 'pet': {'name': 'Rex'}}
+            ]
+        }
+        expected = (
+            "user\n\tname\tAlice\n\tid\t1\n"
+            "user\n\tname\tBob\n\tid\t2\n"
+            "user\n\tid\t3\n\tname\tCarol\n\tnotes\t...\n\t\ta\n\t\tb\n\tpet\n\t\tname\tRex"
+        )
+        self.assertEqual(stringify(data), expected)
+        self.assertEqual(stringify(parse(expected, compact=True)), expected)
 
 
 if __name__ == '__main__':
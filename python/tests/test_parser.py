@@ -1,7 +1,9 @@
 """Tests for TAML parser"""
 
+import json
+import pickle
 import unittest
-from taml import parse, TAMLError
+from taml import parse, stringify, Record, TAMLError
 
 
 class TestParser(unittest.TestCase):
@@ -168,6 +170,91 @@ features
         self.assertEqual(len(result['features']), 4)
         self.assertIn('logging', result['features'])
 
+    
+    def test_container_kind_decided_by_children(self):
+        """Test a parent becomes a dict once any child is a key-value pair"""
+        text = "items\n\tfirst\n\tsecond\n\tname\tvalue\nother\tx"
+        result = parse(text)
+        self.assertEqual(result['items'], {'first': {}, 'second': {}, 'name': 'value'})
+        self.assertEqual(result['other'], 'x')
+    
+    def test_very_deep_nesting(self):
+        """Test deeply nested documents parse in linear time"""
+        depth = 3000
+        text = '\n'.join('\t' * i + f'level{i}' for i in range(depth)) + '\n' + '\t' * depth + 'value\t1'
+        node = parse(text)
+        for i in range(depth):
+            node = node[f'level{i}']
+        self.assertEqual(node, {'value': 1})
+
+    
+    def test_schema_types(self):
+        """Test schema types for key paths skip type inference"""
+        text = "server\n\tport\t8080\n\tversion\t1.10\nuser\n\tzip\t01234\n\tactive\tyes\nuser\n\tzip\t98765\n\tactive\tno"
+        schema = {'server.version': 'string', 'user.zip': 'string', '*.active': 'boolean'}
+        result = parse(text, schema=schema)
+        self.assertEqual(result['server'], {'port': 8080, 'version': '1.10'})
+        self.assertEqual(result['user'], [{'zip': '01234', 'active': True}, {'zip': '98765', 'active': False}])
+    
+    def test_schema_mismatch(self):
+        """Test values that don't match their schema type"""
+        text = "port\thttp"
+        self.assertEqual(parse(text, schema={'port': 'integer'}), {'port': 'http'})
+        with self.assertRaises(TAMLError) as context:
+            parse(text, strict=True, schema={'port': 'integer'})
+        self.assertIn('not a valid integer', str(context.exception))
+    
+    def test_schema_callable(self):
+        """Test a callable schema type"""
+        result = parse("tags\ta,b,c\ncount\t3", schema={'tags': lambda text: text.split(',')})
+        self.assertEqual(result, {'tags': ['a', 'b', 'c'], 'count': 3})
+    
+    def test_keys_shared(self):
+        """Test that the objects of a collection share their key strings"""
+        result = parse("user\n\tname\tAlice\nuser\n\tname\tBob")
+        first, second = (next(iter(user)) for user in result['user'])
+        self.assertIs(first, second)
+    
+    def test_compact_records(self):
+        """Test compact mode turns homogeneous collections into records"""
+        text = ("user\n\tname\tAlice\n\tclass\tadmin\n\tpet\n\t\tname\tRex\n\tpet\n\t\tname\tFelix\n"
+                "user\n\tname\tBob\n\tclass\tguest\n\tpet\n\t\tname\tTom\n\tpet\n\t\tname\tJerry\n"
+                "group\n\tname\tstaff\ngroup\n\tid\t7")
+        result = parse(text, compact=True)
+        self.assertEqual(result, parse(text))
+        alice, bob = result['user']
+        self.assertIsInstance(alice, Record)
+        self.assertEqual((alice.name, alice['class'], bob['pet'][1].name), ('Alice', 'admin', 'Jerry'))
+        self.assertEqual(list(bob), ['name', 'class', 'pet'])
+        self.assertNotIn('id', alice)
+        self.assertEqual(bob.get('id', 0), 0)
+        self.assertEqual(alice._asdict()['name'], 'Alice')
+        # Objects with different keys stay dicts
+        self.assertEqual([type(group) for group in result['group']], [dict, dict])
+        self.assertEqual(pickle.loads(pickle.dumps(result)), result)
+        self.assertEqual(stringify(result), stringify(parse(text)))
+    
+    def test_record_equality(self):
+        """Test records compare equal to mappings with the same items, not to tuples"""
+        alice, bob = parse("user\n\tname\tAlice\n\tid\t1\nuser\n\tname\tBob\n\tid\t2", compact=True)['user']
+        self.assertEqual(alice, {'name': 'Alice', 'id': 1})
+        self.assertEqual(alice, {'id': 1, 'name': 'Alice'})
+        self.assertNotEqual(alice, bob)
+        self.assertNotEqual(alice, ('Alice', 1))
+        self.assertNotEqual(('Alice', 1), alice)
+        self.assertNotIsInstance(alice, tuple)
+        self.assertEqual(list(alice.values()), ['Alice', 1])
+    
+    def test_record_json(self):
+        """Test records serialize to JSON objects with their field names"""
+        text = "user\n\tname\tAlice\n\tid\t1\nuser\n\tname\tBob\n\tid\t2"
+        result = parse(text, compact=True)
+        self.assertEqual(json.dumps(result, default=dict), json.dumps(parse(text)))
+        self.assertEqual(json.loads(json.dumps(result, default=dict))['user'][1], {'name': 'Bob', 'id': 2})
+        # Records aren't lists, so json never writes them without their keys
+        with self.assertRaises(TypeError):
+            json.dumps(result)
+
 
 if __name__ == '__main__':
     unittest.main()
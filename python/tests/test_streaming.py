@@ -0,0 +1,82 @@
+"""Tests for streaming TAML parsing"""
+
+import io
+import unittest
+from taml import parse, iterparse, iter_records, TAMLError
+
+
+class TestIterparse(unittest.TestCase):
+    
+    def test_events(self):
+        """Test events for maps, lists and values"""
+        text = "name\tapp\nserver\n\tport\t8080\nfeatures\n\tauth\n\tlogging"
+        events = list(iterparse(io.StringIO(text)))
+        self.assertEqual(events, [
+            ('value', ('name',), 'app'),
+            ('start_map', ('server',), None),
+            ('value', ('server', 'port'), 8080),
+            ('end_map', ('server',), None),
+            ('start_list', ('features',), None),
+            ('value', ('features', 0), 'auth'),
+            ('value', ('features', 1), 'logging'),
+            ('end_list', ('features',), None),
+        ])
+    
+    def test_raw_text_and_binary_file(self):
+        """Test raw text values read from a binary file"""
+        text = "notes\t...\n\tline one\n\n\tline two\nafter\t~\n"
+        events = list(iterparse(io.BytesIO(text.encode('utf-8'))))
+        self.assertEqual(events, [
+            ('value', ('notes',), 'line one\n\nline two'),
+            ('value', ('after',), None),
+        ])
+    
+    def test_events_are_yielded_while_reading(self):
+        """Test the records of a collection arrive before the rest of the file is read"""
+        lines_read = []
+        
+        def lines():
+            yield "users\n"
+            for i in range(1000):
+                lines_read.append(i)
+                yield "\tuser\n"
+                yield f"\t\tid\t{i}\n"
+        
+        for event, path, value in iterparse(lines()):
+            if event == 'value':
+                self.assertEqual(path, ('users', 'user', 'id'))
+                self.assertEqual(value, 0)
+                break
+        self.assertLess(len(lines_read), 5)
+        
+        lines_read.clear()
+        for record in iter_records(lines(), 'user'):
+            self.assertEqual(record, {'id': 0})
+            break
+        self.assertLess(len(lines_read), 5)
+    
+    def test_strict_error(self):
+        """Test strict mode errors are raised while iterating"""
+        with self.assertRaises(TAMLError) as context:
+            list(iterparse(io.StringIO("key\tvalue\n  bad"), strict=True))
+        self.assertEqual(context.exception.line, 2)
+
+
+class TestIterRecords(unittest.TestCase):
+    
+    def test_records(self):
+        """Test records of a repeated bare key"""
+        text = (
+            "title\tExport\n"
+            "user\n\tname\tAlice\n\troles\n\t\tadmin\n"
+            "user\n\tname\tBob\n\troles\n\t\tviewer\n"
+            "user\n\tname\tCarol\n"
+            "settings\n\tuser\n\t\tname\tsingle\n"
+        )
+        records = list(iter_records(io.StringIO(text), 'user'))
+        self.assertEqual(records, parse(text)['user'])
+        self.assertEqual([record['name'] for record in records], ['Alice', 'Bob', 'Carol'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,155 @@
+"""Tests for loading TAML into typed classes"""
+
+import enum
+import gc
+import unittest
+import weakref
+from dataclasses import dataclass, field
+from datetime import date
+from typing import Dict, List, NamedTuple, Optional
+
+from taml import load_as, TAMLError
+
+try:
+    from typing import TypedDict
+except ImportError:  # Python 3.7
+    TypedDict = None
+
+
+class Level(enum.Enum):
+    DEBUG = 'debug'
+    INFO = 'info'
+
+
+class Point(NamedTuple):
+    x: int
+    y: int = 0
+
+
+@dataclass
+class User:
+    name: str
+    zip: str
+    active: bool = True
+    roles: List[str] = field(default_factory=list)
+
+
+@dataclass
+class Config:
+    version: str
+    port: int
+    level: Level
+    started: date
+    origin: Point
+    user: List[User]
+    ports: List[int]
+    extra: Dict[str, float]
+    note: Optional[str] = None
+
+
+CONFIG = """version\t1.10
+port\t8080
+level\tINFO
+started\t2024-01-05
+origin
+\tx\t3
+user
+\tname\tAlice
+\tzip\t01234
+\troles
+\t\tadmin
+user
+\tname\tBob
+\tzip\t98765
+\tactive\tno
+ports
+\t80
+\t443
+extra
+\tratio\t2
+"""
+
+
+class TestLoadAs(unittest.TestCase):
+    
+    def test_dataclass(self):
+        """Test fields are converted by their type hints"""
+        config = load_as(Config, CONFIG)
+        self.assertEqual(config, Config(
+            version='1.10',
+            port=8080,
+            level=Level.INFO,
+            started=date(2024, 1, 5),
+            origin=Point(3),
+            user=[User('Alice', '01234', True, ['admin']), User('Bob', '98765', False)],
+            ports=[80, 443],
+            extra={'ratio': 2.0},
+        ))
+        self.assertIsInstance(config.extra['ratio'], float)
+    
+    def test_single_record_list(self):
+        """Test a key that appears once fills a list field"""
+        config = load_as(Config, CONFIG.replace('user\n\tname\tBob\n\tzip\t98765\n\tactive\tno\n', ''))
+        self.assertEqual([user.name for user in config.user], ['Alice'])
+    
+    @unittest.skipIf(TypedDict is None, 'TypedDict needs Python 3.8')
+    def test_typed_dict(self):
+        """Test loading a TypedDict"""
+        Server = TypedDict('Server', {'host': str, 'port': int})
+        self.assertEqual(load_as(Server, "host\t10.0.0.1\nport\t22"), {'host': '10.0.0.1', 'port': 22})
+    
+    def test_missing_field(self):
+        """Test a missing required field"""
+        with self.assertRaises(TAMLError):
+            load_as(Point, "y\t1")
+    
+    def test_strict_type_mismatch(self):
+        """Test values that don't match their field type"""
+        self.assertEqual(load_as(Point, "x\tleft").x, 'left')
+        with self.assertRaises(TAMLError) as context:
+            load_as(Point, "x\tleft", strict=True)
+        self.assertEqual(context.exception.line, 1)
+        with self.assertRaises(TAMLError):
+            load_as(Point, "x\t1\nz\t2", strict=True)
+    
+    def test_bare_list_key(self):
+        """Test a list field given a bare key without children is empty"""
+        config = load_as(Config, CONFIG.replace('ports\n\t80\n\t443\n', 'ports\n'))
+        self.assertEqual(config.ports, [])
+        config = load_as(Config, CONFIG.replace('ports\n\t80\n\t443\n', 'ports\n'), strict=True)
+        self.assertEqual(config.ports, [])
+    
+    def test_strict_shape_mismatch(self):
+        """Test nested keys where a list or a value is expected"""
+        text = CONFIG.replace('ports\n\t80\n\t443\n', 'ports\n\thttp\t80\n')
+        self.assertEqual(load_as(Config, text).ports, [{'http': 80}])
+        with self.assertRaises(TAMLError):
+            load_as(Config, text, strict=True)
+        
+        text = CONFIG.replace('port\t8080\n', 'port\n\thttp\t8080\n')
+        self.assertEqual(load_as(Config, text).port, {'http': 8080})
+        with self.assertRaises(TAMLError):
+            load_as(Config, text, strict=True)
+        with self.assertRaises(TAMLError):
+            load_as(Point, "x\n\t1", strict=True)
+    
+    def test_plans_do_not_keep_classes_alive(self):
+        """Test a class can be freed after it has been loaded"""
+        @dataclass
+        class Local:
+            name: str
+        
+        self.assertEqual(load_as(Local, "name\tx"), Local('x'))
+        ref = weakref.ref(Local)
+        del Local
+        gc.collect()
+        self.assertIsNone(ref())
+    
+    def test_not_a_typed_class(self):
+        """Test classes without fields are rejected"""
+        with self.assertRaises(TypeError):
+            load_as(dict, "a\t1")
+
+
+if __name__ == '__main__':
+    unittest.main()
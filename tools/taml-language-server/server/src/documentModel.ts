@@ -0,0 +1,428 @@
+import {
+Diagnostic,
+DiagnosticSeverity,
+SemanticTokensEdit
+} from 'vscode-languageserver/node';
+import { LineSyntax, SyntaxTree, keyToken, parseLine, replace } from './syntaxTree';
+
+// A problem found on one line; the line number is added when diagnostics are built
+export interface LineProblem {
+severity: DiagnosticSeverity;
+start: number;
+end: number;
+message: string;
+}
+
+// Context a line leaves for the next one, and the problems found on it
+export interface LineState {
+indentLevel: number;
+isParent: boolean;
+problems: LineProblem[] | null;
+}
+
+const initialState: LineState = { indentLevel: -1, isParent: false, problems: null };
+
+// Line breaks as TextDocument counts them
+const lineBreak = /\r\n|\r|\n/;
+
+export function splitLines(text: string): string[] {
+return text.split(lineBreak);
+}
+
+// Lines of an open document with the validation state, syntax and semantic
+// tokens of each line. Edits replace ranges of lines, and validate() only
+// revalidates from the first changed line until a line leaves the same
+// context it did before. The syntax tree and the semantic tokens are
+// recomputed for the top-level blocks holding changed lines and spliced into
+// the rest.
+export class DocumentModel {
+lines: string[];
+// State after each line; undefined for lines changed since the last validation
+private states: (LineState | undefined)[];
+// Changed lines not validated yet, empty when dirtyFrom > dirtyTo
+private dirtyFrom = 0;
+private dirtyTo: number;
+private showWarnings = true;
+// Syntax of each line; undefined for lines changed since the tree was built
+private syntax: (LineSyntax | undefined)[];
+private tree: SyntaxTree | undefined;
+// Changed lines not in the tree yet, empty when treeFrom > treeTo
+private treeFrom = 0;
+private treeTo = -1;
+// Semantic tokens of each line as start, length and type triples, as they are
+// in encoded; undefined for lines added since tokens were last encoded
+private tokens: (number[] | undefined)[];
+// Changed lines whose tokens aren't encoded yet, empty when tokensFrom > tokensTo
+private tokensFrom = 0;
+private tokensTo: number;
+// Key of each line that is a top-level bare key with children, how often each
+// such key occurs, and whether its lines are encoded as records
+private topKeys: (string | undefined)[];
+private readonly topKeyCounts = new Map<string, number>();
+private readonly topKeyRecords = new Map<string, boolean>();
+// Top-level keys whose count changed since tokens were last encoded
+private readonly touchedKeys = new Set<string>();
+// Semantic tokens in the LSP encoding, and the span that changed since
+// semanticTokens() last returned them
+private readonly encoded: number[] = [];
+private change: { start: number; oldEnd: number; newEnd: number } | undefined;
+
+constructor(text: string) {
+this.lines = splitLines(text);
+this.states = new Array(this.lines.length);
+this.syntax = new Array(this.lines.length);
+this.dirtyTo = this.lines.length - 1;
+this.tokens = new Array(this.lines.length);
+this.topKeys = new Array(this.lines.length);
+this.tokensTo = this.lines.length - 1;
+}
+
+setText(text: string): void {
+this.lines = splitLines(text);
+this.states = new Array(this.lines.length);
+this.syntax = new Array(this.lines.length);
+this.tree = undefined;
+this.dirtyFrom = 0;
+this.dirtyTo = this.lines.length - 1;
+this.recordChange(0, this.encoded.length, 0);
+this.encoded.length = 0;
+this.tokens = new Array(this.lines.length);
+this.topKeys = new Array(this.lines.length);
+this.topKeyCounts.clear();
+this.topKeyRecords.clear();
+this.touchedKeys.clear();
+this.tokensFrom = 0;
+this.tokensTo = this.lines.length - 1;
+}
+
+// Replace lines start..oldEnd (inclusive) with newLines
+replaceLines(start: number, oldEnd: number, newLines: string[]): void {
+const deleteCount = oldEnd - start + 1;
+replace(this.lines, start, deleteCount, newLines);
+replace(this.states, start, deleteCount, new Array<LineState | undefined>(newLines.length));
+replace(this.syntax, start, deleteCount, new Array<LineSyntax | undefined>(newLines.length));
+
+// The replaced lines' tokens leave the encoding now; the new lines' are added
+// when tokens are next requested
+const offset = this.tokenOffset(start);
+let removed = 0;
+for (let i = start; i <= oldEnd; i++) {
+const tokens = this.tokens[i];
+if (tokens !== undefined) removed += tokens.length / 3 * 5;
+const key = this.topKeys[i];
+if (key !== undefined) this.countTopKey(key, -1);
+}
+if (removed > 0) {
+this.encoded.splice(offset, removed);
+this.recordChange(offset, removed, 0);
+}
+replace(this.tokens, start, deleteCount, new Array<number[] | undefined>(newLines.length));
+replace(this.topKeys, start, deleteCount, new Array<string | undefined>(newLines.length));
+
+const newEnd = start + newLines.length - 1;
+[this.dirtyFrom, this.dirtyTo] = mergeChange(this.dirtyFrom, this.dirtyTo, start, oldEnd, newEnd);
+[this.tokensFrom, this.tokensTo] = mergeChange(this.tokensFrom, this.tokensTo, start, oldEnd, newEnd);
+// A deletion leaves no changed line, so the line after it counts as one
+[this.treeFrom, this.treeTo] = mergeChange(this.treeFrom, this.treeTo, start, oldEnd, Math.max(newEnd, start));
+}
+
+syntaxTree(): SyntaxTree {
+const { lines } = this;
+if (this.tree === undefined) {
+for (let i = 0; i < lines.length; i++) this.lineSyntax(i);
+this.tree = new SyntaxTree(lines, this.syntax as LineSyntax[]);
+} else if (this.treeFrom <= this.treeTo) {
+const [first, end] = this.changedBlocks(this.treeFrom, this.treeTo);
+const oldEnd = end - (lines.length - this.tree.kinds.length);
+this.tree.splice(first, oldEnd, this.blockTree(first, end));
+}
+this.treeFrom = lines.length;
+this.treeTo = -1;
+return this.tree;
+}
+
+// Semantic tokens in the LSP encoding, and the edits that turn the tokens
+// this last returned into them
+semanticTokens(): { data: number[]; edits: SemanticTokensEdit[] } {
+if (this.tokensFrom <= this.tokensTo) this.encodeTokens();
+const { encoded, change } = this;
+this.change = undefined;
+const edits = change === undefined ? [] : [{ start: change.start, deleteCount: change.oldEnd - change.start, data: encoded.slice(change.start, change.newEnd) }];
+return { data: encoded, edits };
+}
+
+private lineSyntax(line: number): LineSyntax {
+let syntax = this.syntax[line];
+if (syntax === undefined) {
+syntax = parseLine(this.lines[line]);
+this.syntax[line] = syntax;
+}
+return syntax;
+}
+
+// A key at indent 0 closes every open block, so the kinds of the lines
+// between two of them only depend on those lines and, for top-level keys
+// with children, on how often each occurs in the whole document
+private startsTopLevelBlock(line: number): boolean {
+const syntax = this.lineSyntax(line);
+return syntax.indent === 0 && (syntax.kind === 'key' || syntax.kind === 'pair');
+}
+
+// Lines first..end - 1 of the top-level blocks holding changed lines from..to
+private changedBlocks(from: number, to: number): [number, number] {
+const { lines } = this;
+// The block before the changed lines may have run into them
+let first = Math.min(from, lines.length) - 1;
+while (first > 0 && !this.startsTopLevelBlock(first)) first--;
+first = Math.max(first, 0);
+let end = Math.min(to, lines.length - 1) + 1;
+while (end < lines.length && !this.startsTopLevelBlock(end)) end++;
+return [first, end];
+}
+
+// Syntax tree of lines first..end - 1, which are whole top-level blocks
+private blockTree(first: number, end: number): SyntaxTree {
+const syntax: LineSyntax[] = [];
+for (let i = first; i < end; i++) syntax.push(this.lineSyntax(i));
+return new SyntaxTree(this.lines.slice(first, end), syntax);
+}
+
+// Recompute the tokens of the top-level blocks holding changed lines and
+// splice them into the encoding
+private encodeTokens(): void {
+const { lines, tokens, topKeys, encoded } = this;
+const [first, end] = this.changedBlocks(this.tokensFrom, this.tokensTo);
+this.tokensFrom = lines.length;
+this.tokensTo = -1;
+const tree = this.blockTree(first, end);
+for (let i = first; i < end; i++) {
+const key = topKeys[i];
+if (key !== undefined) this.countTopKey(key, -1);
+}
+for (let i = first; i < end; i++) {
+const key = tree.topKey(i - first);
+topKeys[i] = key;
+if (key !== undefined) this.countTopKey(key, 1);
+}
+
+// Encode the block's tokens after the last token before it
+let previousLine = 0;
+let previousStart = 0;
+for (let i = first - 1; i >= 0; i--) {
+const lineTokens = tokens[i]!;
+if (lineTokens.length === 0) continue;
+previousLine = i;
+previousStart = lineTokens[lineTokens.length - 3];
+break;
+}
+const offset = this.tokenOffset(first);
+let oldLength = 0;
+const data: number[] = [];
+for (let i = first; i < end; i++) {
+const old = tokens[i];
+if (old !== undefined) oldLength += old.length / 3 * 5;
+const lineTokens = tree.lineTokens(i - first, this.topKeyCounts);
+tokens[i] = lineTokens;
+for (let j = 0; j < lineTokens.length; j += 3) {
+const start = lineTokens[j];
+data.push(i - previousLine, i === previousLine ? start - previousStart : start, lineTokens[j + 1], lineTokens[j + 2], 0);
+previousLine = i;
+previousStart = start;
+}
+}
+// The first token after the block is now relative to a different line
+for (let i = end; i < lines.length; i++) {
+if (tokens[i]!.length === 0) continue;
+data.push(i - previousLine);
+oldLength++;
+break;
+}
+// Most of a block's tokens come out as they were; only the rest is replaced
+// and sent
+let head = 0;
+const shorter = Math.min(oldLength, data.length);
+while (head < shorter && encoded[offset + head] === data[head]) head++;
+let tail = 0;
+while (tail < shorter - head && encoded[offset + oldLength - 1 - tail] === data[data.length - 1 - tail]) tail++;
+if (head + tail < oldLength || head + tail < data.length) {
+replace(encoded, offset + head, oldLength - head - tail, data.slice(head, data.length - tail));
+this.recordChange(offset + head, oldLength - head - tail, data.length - head - tail);
+}
+this.updateRecords(first, end);
+}
+
+// Re-encode the key tokens of top-level keys outside first..end - 1 whose
+// record status changed with the number of times they occur. A key without a
+// status yet has no lines outside, since their tokens would have set it.
+private updateRecords(first: number, end: number): void {
+const { tokens, topKeys, encoded } = this;
+const changed = new Map<string, number>();
+for (const key of this.touchedKeys) {
+const count = this.topKeyCounts.get(key) ?? 0;
+const record = count > 1;
+const previous = this.topKeyRecords.get(key);
+if (count === 0) this.topKeyRecords.delete(key);
+else this.topKeyRecords.set(key, record);
+if (previous !== undefined && count > 0 && previous !== record) changed.set(key, keyToken(record));
+}
+this.touchedKeys.clear();
+if (changed.size === 0) return;
+
+let offset = 0;
+for (let i = 0; i < tokens.length; i++) {
+const lineTokens = tokens[i]!;
+const key = topKeys[i];
+if (key !== undefined && (i < first || i >= end) && changed.has(key)) {
+lineTokens[2] = changed.get(key)!;
+encoded[offset + 3] = lineTokens[2];
+this.recordChange(offset + 3, 1, 1);
+}
+offset += lineTokens.length / 3 * 5;
+}
+}
+
+private countTopKey(key: string, delta: number): void {
+const count = (this.topKeyCounts.get(key) ?? 0) + delta;
+if (count > 0) this.topKeyCounts.set(key, count);
+else this.topKeyCounts.delete(key);
+this.touchedKeys.add(key);
+}
+
+// Index in encoded of the first token of a line, or of the next line with tokens
+private tokenOffset(line: number): number {
+let offset = 0;
+for (let i = 0; i < line; i++) {
+const tokens = this.tokens[i];
+if (tokens !== undefined) offset += tokens.length / 3 * 5;
+}
+return offset;
+}
+
+// Widen the span of encoded that changed since tokens were last returned by
+// a splice of it
+private recordChange(start: number, deleteCount: number, insertCount: number): void {
+const change = this.change;
+if (change === undefined) {
+this.change = { start, oldEnd: start + deleteCount, newEnd: start + insertCount };
+return;
+}
+// Past the span, positions in encoded and in the last result differ by a fixed shift
+const end = Math.max(change.newEnd, start + deleteCount);
+change.oldEnd += end - change.newEnd;
+change.start = Math.min(change.start, start);
+change.newEnd = end - deleteCount + insertCount;
+}
+
+validate(showWarnings: boolean): Diagnostic[] {
+if (showWarnings !== this.showWarnings) {
+// Every line's problems may change, so nothing can be reused
+this.showWarnings = showWarnings;
+this.states = new Array(this.lines.length);
+this.dirtyFrom = 0;
+this.dirtyTo = this.lines.length - 1;
+}
+
+const { lines, states } = this;
+if (this.dirtyFrom <= this.dirtyTo) {
+let state = this.dirtyFrom > 0 ? states[this.dirtyFrom - 1]! : initialState;
+for (let i = this.dirtyFrom; i < lines.length; i++) {
+const previous = states[i];
+const next = validateLine(lines[i], state, showWarnings);
+states[i] = next;
+// Past the edit, the rest of the document is unchanged once the context matches again
+if (i >= this.dirtyTo && previous !== undefined &&
+previous.indentLevel === next.indentLevel && previous.isParent === next.isParent) {
+break;
+}
+state = next;
+}
+this.dirtyFrom = lines.length;
+this.dirtyTo = -1;
+}
+
+const diagnostics: Diagnostic[] = [];
+for (let i = 0; i < states.length; i++) {
+const problems = states[i]!.problems;
+if (problems === null) continue;
+for (const problem of problems) {
+diagnostics.push({ severity: problem.severity, range: { start: { line: i, character: problem.start }, end: { line: i, character: problem.end } }, message: problem.message, source: 'taml' });
+}
+}
+return diagnostics;
+}
+}
+
+// Changed line range from..to (empty when from > to) after lines start..oldEnd
+// are replaced by lines start..newEnd
+function mergeChange(from: number, to: number, start: number, oldEnd: number, newEnd: number): [number, number] {
+if (from > to) return [start, newEnd];
+return [Math.min(from, start), to > oldEnd ? to + newEnd - oldEnd : newEnd];
+}
+
+function validateLine(line: string, previousLine: LineState, showWarnings: boolean): LineState {
+if (!line.trim() || line.trimStart().startsWith('#')) {
+return { indentLevel: previousLine.indentLevel, isParent: false, problems: null };
+}
+
+const lineInfo: LineState = { indentLevel: 0, isParent: false, problems: null };
+const problems: LineProblem[] = [];
+const report = (severity: DiagnosticSeverity, start: number, end: number, message: string) => {
+problems.push({ severity, start, end, message });
+lineInfo.problems = problems;
+};
+
+if (line.length > 0 && line[0] === ' ') {
+report(DiagnosticSeverity.Error, 0, 1, 'Indentation must use tabs, not spaces');
+return lineInfo;
+}
+
+let indentLevel = 0;
+for (let i = 0; i < line.length; i++) {
+if (line[i] === '\t') indentLevel++;
+else if (line[i] === ' ') {
+report(DiagnosticSeverity.Error, i, i + 1, 'Mixed spaces and tabs in indentation');
+return lineInfo;
+} else break;
+}
+
+lineInfo.indentLevel = indentLevel;
+
+if (previousLine.indentLevel >= 0) {
+if (indentLevel > previousLine.indentLevel + 1) {
+report(DiagnosticSeverity.Error, 0, indentLevel, `Invalid indentation level (expected max ${previousLine.indentLevel + 1} tabs, found ${indentLevel})`);
+}
+if (indentLevel > previousLine.indentLevel && !previousLine.isParent) {
+report(DiagnosticSeverity.Error, 0, indentLevel, 'Indented line has no parent (previous line was not a parent key)');
+}
+}
+
+const content = line.substring(indentLevel);
+if (!content.trim()) {
+report(DiagnosticSeverity.Error, indentLevel, line.length, 'Line has no content after indentation');
+return lineInfo;
+}
+
+const firstTabIndex = content.indexOf('\t');
+if (firstTabIndex === -1) {
+lineInfo.isParent = true;
+if (showWarnings && content.includes('  ')) {
+const idx = content.indexOf('  ');
+report(DiagnosticSeverity.Warning, indentLevel + idx, indentLevel + idx + 2, 'Key contains multiple spaces (did you mean to use tabs?)');
+}
+} else if (firstTabIndex === 0) {
+report(DiagnosticSeverity.Error, indentLevel, indentLevel + 1, 'Key is empty (line starts with tab)');
+} else {
+lineInfo.isParent = false;
+let valueStart = firstTabIndex;
+while (valueStart < content.length && content[valueStart] === '\t') valueStart++;
+if (valueStart < content.length) {
+const value = content.substring(valueStart);
+if (value.includes('\t')) {
+const tabIdx = value.indexOf('\t');
+report(DiagnosticSeverity.Error, indentLevel + valueStart + tabIdx, indentLevel + valueStart + tabIdx + 1, 'Value contains invalid tab character');
+}
+}
+}
+
+return lineInfo;
+}
@@ -0,0 +1,94 @@
+import {
+CancellationToken,
+CancellationTokenSource
+} from 'vscode-languageserver/node';
+
+export type ValidationRun = (uri: string, token: CancellationToken) => Promise<void>;
+
+// Debounces validation per document. Once a document's delay has passed it
+// is queued, and at most `concurrency` runs go at a time: the active
+// document first, then visible ones, then the rest in the order they became
+// due. Scheduling a document again cancels its pending or running validation,
+// and the event loop is yielded between runs so requests aren't starved.
+export class ValidationScheduler {
+private readonly run: ValidationRun;
+private readonly delay: number;
+private readonly concurrency: number;
+private readonly timers = new Map<string, NodeJS.Timeout>();
+// Documents due for validation, in the order they became due
+private readonly ready = new Set<string>();
+private readonly running = new Map<string, CancellationTokenSource>();
+private active: string | undefined;
+private visible = new Set<string>();
+private pumpPending = false;
+
+constructor(run: ValidationRun, delay: number, concurrency = 1) {
+this.run = run;
+this.delay = delay;
+this.concurrency = concurrency;
+}
+
+schedule(uri: string, delay = this.delay): void {
+this.cancel(uri);
+this.timers.set(uri, setTimeout(() => {
+this.timers.delete(uri);
+this.ready.add(uri);
+this.schedulePump();
+}, delay));
+}
+
+cancel(uri: string): void {
+const timer = this.timers.get(uri);
+if (timer !== undefined) {
+clearTimeout(timer);
+this.timers.delete(uri);
+}
+this.ready.delete(uri);
+this.running.get(uri)?.cancel();
+}
+
+setVisible(active: string | undefined, visible: string[]): void {
+this.active = active;
+this.visible = new Set(visible);
+}
+
+// Runs start from a fresh turn of the event loop, so documents that become
+// due together are ordered by priority and pending requests go first
+private schedulePump(): void {
+if (this.pumpPending) return;
+this.pumpPending = true;
+setImmediate(() => {
+this.pumpPending = false;
+this.pump();
+});
+}
+
+private pump(): void {
+while (this.running.size < this.concurrency) {
+const uri = this.next();
+if (uri === undefined) return;
+this.ready.delete(uri);
+const source = new CancellationTokenSource();
+this.running.set(uri, source);
+const done = () => {
+this.running.delete(uri);
+source.dispose();
+this.schedulePump();
+};
+this.run(uri, source.token).then(done, done);
+}
+}
+
+private next(): string | undefined {
+let visible: string | undefined;
+let first: string | undefined;
+for (const uri of this.ready) {
+// A document's runs don't overlap; it waits for the cancelled one to finish
+if (this.running.has(uri)) continue;
+if (uri === this.active) return uri;
+if (visible === undefined && this.visible.has(uri)) visible = uri;
+if (first === undefined) first = uri;
+}
+return visible ?? first;
+}
+}
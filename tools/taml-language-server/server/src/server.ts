@@ -1,31 +1,119 @@
 import {
 createConnection,
 TextDocuments,
-Diagnostic,
-DiagnosticSeverity,
 ProposedFeatures,
 InitializeParams,
 DidChangeConfigurationNotification,
 TextDocumentSyncKind,
-InitializeResult
+InitializeResult,
+CancellationToken,
+Diagnostic,
+DocumentSymbol,
+FoldingRange,
+FileChangeType
 } from 'vscode-languageserver/node';
 
 import {
-TextDocument
+TextDocument,
+TextDocumentContentChangeEvent
 } from 'vscode-languageserver-textdocument';
 
+import * as os from 'os';
+import * as path from 'path';
+import { fileURLToPath } from 'url';
+import { splitLines } from './documentModel';
+import { semanticTokensLegend } from './syntaxTree';
+import { ValidationScheduler } from './scheduler';
+import { WorkerPool } from './workerPool';
+import { LineEdit } from './workerProtocol';
+import { WorkspaceIndex } from './workspaceIndex';
+
 const connection = createConnection(ProposedFeatures.all);
-const documents: TextDocuments<TextDocument> = new TextDocuments(TextDocument);
+
+// Validation runs on worker threads, leaving this thread free for requests.
+// One core is left for the LSP thread itself.
+const pool = new WorkerPool(Math.max(1, Math.min(4, os.cpus().length - 1)), uri => documents.get(uri)?.getText());
+
+// Line count of each open document as the workers see it
+const lineCounts = new Map<string, number>();
+
+const documents: TextDocuments<TextDocument> = new TextDocuments({
+create(uri: string, languageId: string, version: number, content: string): TextDocument {
+lineCounts.set(uri, splitLines(content).length);
+pool.open(uri, content);
+return TextDocument.create(uri, languageId, version, content);
+},
+update(document: TextDocument, changes: TextDocumentContentChangeEvent[], version: number): TextDocument {
+let edits: LineEdit[] = [];
+let lineCount = lineCounts.get(document.uri) ?? 0;
+for (const change of changes) {
+if (!('range' in change)) {
+document = TextDocument.update(document, [change], version);
+edits = [{ text: change.text }];
+lineCount = document.lineCount;
+continue;
+}
+const start = change.range.start.line;
+const oldEnd = change.range.end.line;
+const oldLineCount = document.lineCount;
+document = TextDocument.update(document, [change], version);
+const lines = readLines(document, start, oldEnd + document.lineCount - oldLineCount);
+edits.push({ start, oldEnd, lines });
+lineCount += lines.length - (oldEnd - start + 1);
+}
+if (lineCount !== document.lineCount) {
+edits = [{ text: document.getText() }];
+lineCount = document.lineCount;
+}
+lineCounts.set(document.uri, lineCount);
+pool.edit(document.uri, edits);
+return document;
+}
+});
+
+// Text of lines first..last without their line breaks
+function readLines(document: TextDocument, first: number, last: number): string[] {
+const lines: string[] = [];
+for (let line = first; line <= last; line++) {
+const text = document.getText({ start: { line, character: 0 }, end: { line: line + 1, character: 0 } });
+lines.push(text.replace(/(\r\n|\r|\n)$/, ''));
+}
+return lines;
+}
 
 let hasConfigurationCapability = false;
 
+// Key paths of the workspace's files, for workspace symbols and cross-file checks
+const workspaceIndex = new WorkspaceIndex(text => pool.indexText(text), () => {
+for (const document of documents.all()) {
+scheduler.schedule(document.uri);
+}
+});
+let workspaceFolders: string[] = [];
+let storagePath = path.join(os.tmpdir(), 'taml-language-server');
+
 connection.onInitialize((params: InitializeParams) => {
 const capabilities = params.capabilities;
 hasConfigurationCapability = !!(capabilities.workspace && !!capabilities.workspace.configuration);
 
+const folders = params.workspaceFolders ?? (params.rootUri ? [{ uri: params.rootUri, name: '' }] : []);
+workspaceFolders = folders.filter(folder => folder.uri.startsWith('file:')).map(folder => fileURLToPath(folder.uri));
+// Set by the client to its workspace storage directory
+if (params.initializationOptions?.storagePath) {
+storagePath = params.initializationOptions.storagePath;
+}
+
 const result: InitializeResult = {
 capabilities: {
-textDocumentSync: TextDocumentSyncKind.Incremental
+textDocumentSync: TextDocumentSyncKind.Incremental,
+documentSymbolProvider: true,
+foldingRangeProvider: true,
+selectionRangeProvider: true,
+workspaceSymbolProvider: true,
+semanticTokensProvider: {
+legend: semanticTokensLegend,
+full: { delta: true }
+}
 }
 };
 return result;
@@ -35,8 +123,25 @@ connection.onInitialized(() => {
 if (hasConfigurationCapability) {
 connection.client.register(DidChangeConfigurationNotification.type, undefined);
 }
+if (workspaceFolders.length > 0) {
+workspaceIndex.start(workspaceFolders, storagePath).catch(error => {
+connection.console.error(`Indexing the workspace failed: ${error}`);
+});
+}
 });
 
+// Sent for the **/*.taml watcher the client registers
+connection.onDidChangeWatchedFiles(params => {
+for (const change of params.changes) {
+if (!change.uri.startsWith('file:')) continue;
+const file = fileURLToPath(change.uri);
+if (change.type === FileChangeType.Deleted) workspaceIndex.remove(file);
+else workspaceIndex.update(file);
+}
+});
+
+connection.onWorkspaceSymbol(params => workspaceIndex.symbols(params.query));
+
 interface TamlSettings {
 validation: { enable: boolean; showWarnings: boolean; };
 }
@@ -44,93 +149,111 @@ validation: { enable: boolean; showWarnings: boolean; };
 const defaultSettings: TamlSettings = { validation: { enable: true, showWarnings: true } };
 let globalSettings: TamlSettings = defaultSettings;
 
+// Milliseconds without further edits before a changed document is validated
+const validationDelay = 200;
+
+// One validation per worker at a time
+const scheduler = new ValidationScheduler(validateTextDocument, validationDelay, pool.size);
+
+// Sent by the client when the active or visible editors change
+interface VisibleDocumentsParams {
+active?: string;
+visible: string[];
+}
+
+let hasVisibleDocuments = false;
+
+connection.onNotification('taml/didChangeVisibleDocuments', (params: VisibleDocumentsParams) => {
+hasVisibleDocuments = true;
+scheduler.setVisible(params.active, params.visible);
+});
+
 connection.onDidChangeConfiguration(change => {
 globalSettings = (change.settings.taml || defaultSettings);
-documents.all().forEach(validateTextDocument);
+for (const document of documents.all()) {
+scheduler.schedule(document.uri, 0);
+}
 });
 
 documents.onDidChangeContent(change => {
-validateTextDocument(change.document);
+if (!hasVisibleDocuments) {
+// Without word from the client, the document being edited is taken to be the active one
+scheduler.setVisible(change.document.uri, []);
+}
+scheduler.schedule(change.document.uri);
 });
 
-async function validateTextDocument(textDocument: TextDocument): Promise<void> {
-const diagnostics: Diagnostic[] = [];
-const lines = textDocument.getText().split(/\r?\n/);
-
-let previousLine = { indentLevel: -1, isParent: false };
+documents.onDidClose(event => {
+scheduler.cancel(event.document.uri);
+pool.close(event.document.uri);
+lineCounts.delete(event.document.uri);
+structureCache.delete(event.document.uri);
+});
 
-for (let i = 0; i < lines.length; i++) {
-const line = lines[i];
-if (!line.trim() || line.trimStart().startsWith('#')) {
-previousLine = { indentLevel: previousLine.indentLevel, isParent: false };
-continue;
+async function validateTextDocument(uri: string, token: CancellationToken): Promise<void> {
+if (!documents.get(uri)) return;
+let diagnostics: Diagnostic[] = [];
+if (globalSettings.validation.enable) {
+try {
+diagnostics = await pool.validate(uri, globalSettings.validation.showWarnings);
+if (globalSettings.validation.showWarnings && workspaceIndex.size > 0) {
+diagnostics.push(...workspaceIndex.crossFileDiagnostics(uri, await pool.indexEntries(uri)));
 }
-
-const lineInfo = validateLine(line, i, previousLine, diagnostics, globalSettings.validation.showWarnings);
-previousLine = lineInfo;
+} catch (error) {
+connection.console.error(`Validation of ${uri} failed: ${error}`);
+return;
 }
-
-connection.sendDiagnostics({ uri: textDocument.uri, diagnostics });
 }
-
-function validateLine(line: string, lineNumber: number, previousLine: any, diagnostics: Diagnostic[], showWarnings: boolean) {
-const lineInfo = { indentLevel: 0, isParent: false };
-
-if (line.length > 0 && line[0] === ' ') {
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: 0 }, end: { line: lineNumber, character: 1 } }, message: 'Indentation must use tabs, not spaces', source: 'taml' });
-return lineInfo;
+// A newer edit or closing the document made the result stale
+if (token.isCancellationRequested) return;
+connection.sendDiagnostics({ uri, diagnostics });
 }
 
-let indentLevel = 0;
-for (let i = 0; i < line.length; i++) {
-if (line[i] === '\t') indentLevel++;
-else if (line[i] === ' ') {
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: i }, end: { line: lineNumber, character: i + 1 } }, message: 'Mixed spaces and tabs in indentation', source: 'taml' });
-return lineInfo;
-} else break;
+// Structure requests are answered from each document's syntax tree, which the
+// worker rebuilds at most once per edit. The outline, breadcrumbs and folding
+// ask again for the same version, so results are kept until the next edit.
+interface StructureCache {
+version: number;
+symbols?: Promise<DocumentSymbol[]>;
+folding?: Promise<FoldingRange[]>;
 }
 
-lineInfo.indentLevel = indentLevel;
+const structureCache = new Map<string, StructureCache>();
 
-if (previousLine.indentLevel >= 0) {
-if (indentLevel > previousLine.indentLevel + 1) {
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: 0 }, end: { line: lineNumber, character: indentLevel } }, message: `Invalid indentation level (expected max ${previousLine.indentLevel + 1} tabs, found ${indentLevel})`, source: 'taml' });
-}
-if (indentLevel > previousLine.indentLevel && !previousLine.isParent) {
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: 0 }, end: { line: lineNumber, character: indentLevel } }, message: 'Indented line has no parent (previous line was not a parent key)', source: 'taml' });
+function cachedStructure(uri: string): StructureCache | undefined {
+const document = documents.get(uri);
+if (!document) return undefined;
+let cache = structureCache.get(uri);
+if (!cache || cache.version !== document.version) {
+cache = { version: document.version };
+structureCache.set(uri, cache);
 }
+return cache;
 }
 
-const content = line.substring(indentLevel);
-if (!content.trim()) {
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: indentLevel }, end: { line: lineNumber, character: line.length } }, message: 'Line has no content after indentation', source: 'taml' });
-return lineInfo;
-}
+connection.onDocumentSymbol(params => {
+const cache = cachedStructure(params.textDocument.uri);
+if (!cache) return [];
+return cache.symbols ??= pool.documentSymbols(params.textDocument.uri);
+});
 
-const firstTabIndex = content.indexOf('\t');
-if (firstTabIndex === -1) {
-lineInfo.isParent = true;
-if (showWarnings && content.includes('  ')) {
-const idx = content.indexOf('  ');
-diagnostics.push({ severity: DiagnosticSeverity.Warning, range: { start: { line: lineNumber, character: indentLevel + idx }, end: { line: lineNumber, character: indentLevel + idx + 2 } }, message: 'Key contains multiple spaces (did you mean to use tabs?)', source: 'taml' });
-}
-} else if (firstTabIndex === 0) {
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: indentLevel }, end: { line: lineNumber, character: indentLevel + 1 } }, message: 'Key is empty (line starts with tab)', source: 'taml' });
-} else {
-lineInfo.isParent = false;
-let valueStart = firstTabIndex;
-while (valueStart < content.length && content[valueStart] === '\t') valueStart++;
-if (valueStart < content.length) {
-const value = content.substring(valueStart);
-if (value.includes('\t')) {
-const tabIdx = value.indexOf('\t');
-diagnostics.push({ severity: DiagnosticSeverity.Error, range: { start: { line: lineNumber, character: indentLevel + valueStart + tabIdx }, end: { line: lineNumber, character: indentLevel + valueStart + tabIdx + 1 } }, message: 'Value contains invalid tab character', source: 'taml' });
-}
-}
-}
+connection.onFoldingRanges(params => {
+const cache = cachedStructure(params.textDocument.uri);
+if (!cache) return [];
+return cache.folding ??= pool.foldingRanges(params.textDocument.uri);
+});
 
-return lineInfo;
-}
+connection.onSelectionRanges(params => pool.selectionRanges(params.textDocument.uri, params.positions));
+
+// Highlighting that tells keys, records and value types apart. After the
+// first request, only the changed part of the token array is sent.
+connection.languages.semanticTokens.on(params => pool.semanticTokens(params.textDocument.uri));
+
+connection.languages.semanticTokens.onDelta(params => pool.semanticTokensDelta(params.textDocument.uri, params.previousResultId));
+
+connection.onShutdown(() => {
+pool.dispose();
+});
 
 documents.listen(connection);
 connection.listen();
@@ -0,0 +1,553 @@
+import {
+DocumentSymbol,
+FoldingRange,
+FoldingRangeKind,
+Position,
+Range,
+SelectionRange,
+SemanticTokensLegend,
+SymbolKind
+} from 'vscode-languageserver/node';
+
+export type LineKind = 'blank' | 'comment' | 'key' | 'pair' | 'invalid';
+
+// Where the parts of one line are. The key runs from indent to keyEnd, and a
+// pair's value from valueStart to the end of the line. A comment starts at
+// indent. type is the inferred type of a pair's value, or of a bare key's
+// text for when it is a list item.
+export interface LineSyntax {
+kind: LineKind;
+indent: number;
+keyEnd: number;
+valueStart: number;
+type: ValueType;
+}
+
+// What a key line is, given its children and its parent:
+// pair        key and value
+// object      bare key with key-value or mixed children
+// list        bare key whose children are all childless bare keys
+// collection  bare key with repeated child keys, each an object
+// record      object in a collection, or a repeated top-level key
+// item        childless bare key in a list
+// empty       any other childless bare key
+export type NodeKind = 'pair' | 'object' | 'list' | 'collection' | 'record' | 'item' | 'empty';
+
+export type ValueType = 'null' | 'empty' | 'boolean' | 'date' | 'number' | 'string';
+
+const blankLine: LineSyntax = { kind: 'blank', indent: 0, keyEnd: 0, valueStart: -1, type: 'string' };
+const invalidLine: LineSyntax = { kind: 'invalid', indent: 0, keyEnd: 0, valueStart: -1, type: 'string' };
+
+// Lines whose indentation has a space in it are invalid and left out of the
+// tree; lines indented too deeply still parse as keys. Raw text lines depend
+// on the lines before them, so SyntaxTree finds them.
+export function parseLine(line: string): LineSyntax {
+if (!line.trim()) return blankLine;
+const content = line.trimStart();
+if (content.startsWith('#')) {
+return { kind: 'comment', indent: line.length - content.length, keyEnd: line.length, valueStart: -1, type: 'string' };
+}
+
+let indent = 0;
+while (indent < line.length && line[indent] === '\t') indent++;
+if (line[indent] === ' ') return invalidLine;
+
+const tab = line.indexOf('\t', indent);
+if (tab === -1) {
+return { kind: 'key', indent, keyEnd: line.length, valueStart: -1, type: valueType(line.substring(indent)) };
+}
+let valueStart = tab;
+while (valueStart < line.length && line[valueStart] === '\t') valueStart++;
+return { kind: 'pair', indent, keyEnd: tab, valueStart, type: valueType(line.substring(valueStart)) };
+}
+
+// Value of a pair whose value is the block of more deeply indented lines after it
+const rawTextMarker = '...';
+
+// Whether a line starts with at least the given number of tabs
+function startsWithTabs(line: string, tabs: number): boolean {
+for (let i = 0; i < tabs; i++) {
+if (line[i] !== '\t') return false;
+}
+return true;
+}
+
+const truthy = new Set(['true', 'yes', 'on']);
+const falsy = new Set(['false', 'no', 'off']);
+const isoDate = /^\d{4}-\d{2}(?:-\d{2}(?:T\d{2}:\d{2}(?::\d{2}(?:\.\d+)?)?(?:Z|[+-]\d{2}:\d{2})?)?)?$/;
+const number = /^-?\d+(?:\.\d+)?$/;
+
+// Type a value's text converts to, as the TAML parsers infer it
+export function valueType(text: string): ValueType {
+if (text === '~') return 'null';
+if (text === '""') return 'empty';
+const lower = text.toLowerCase();
+if (truthy.has(lower) || falsy.has(lower)) return 'boolean';
+if (isoDate.test(text) && !isNaN(new Date(text).getTime())) return 'date';
+if (number.test(text)) return 'number';
+return 'string';
+}
+
+// Key path in a file, with where it is first defined. Paths join keys with
+// dots and skip list indexes, as schema paths do (`users.user.id`).
+export interface IndexEntry {
+path: string;
+line: number;
+start: number;
+end: number;
+kind: NodeKind;
+// Times the path occurs; the records of a collection share one path
+count: number;
+// Type of the path's values when every non-null value has the same one
+type: ValueType | null;
+}
+
+export function symbolKind(kind: NodeKind, type: ValueType): SymbolKind {
+switch (kind) {
+case 'object': return SymbolKind.Object;
+case 'list':
+case 'collection': return SymbolKind.Array;
+case 'record': return SymbolKind.Struct;
+case 'empty': return SymbolKind.Key;
+}
+switch (type) {
+case 'null': return SymbolKind.Null;
+case 'boolean': return SymbolKind.Boolean;
+case 'number': return SymbolKind.Number;
+default: return SymbolKind.String;
+}
+}
+
+// Keys are properties, except the keys of records; list items and values are
+// typed by what they convert to
+const tokenTypes = ['property', 'struct', 'string', 'number', 'keyword', 'comment'];
+const propertyToken = 0;
+const structToken = 1;
+const stringToken = 2;
+const commentToken = 5;
+
+export const semanticTokensLegend: SemanticTokensLegend = { tokenTypes, tokenModifiers: [] };
+
+// Type of a key's token
+export function keyToken(record: boolean): number {
+return record ? structToken : propertyToken;
+}
+
+const noTokens: number[] = [];
+
+function valueToken(type: ValueType): number {
+switch (type) {
+case 'number':
+case 'date': return 3;
+case 'boolean':
+case 'null':
+case 'empty': return 4;
+default: return stringToken;
+}
+}
+
+// Structure of a document, built in one pass over the syntax of its lines.
+// Nodes are identified by their line; results for requests are computed on
+// first use and kept until the next edit. An edit rebuilds only the
+// top-level blocks holding changed lines, and splice() puts them in place.
+export class SyntaxTree {
+readonly lines: string[];
+readonly syntax: LineSyntax[];
+// Kind of the node on each line, undefined for lines that aren't nodes
+kinds: (NodeKind | undefined)[];
+// Line of each node's parent, -1 at the top level
+parents: Int32Array;
+// Last node line of each node's subtree, or of a raw text block's text
+ends: Int32Array;
+// Indentation stripped from each line of raw text, 0 for other lines
+rawIndents: Int32Array;
+// Key of each top-level bare key with children, and how often each occurs
+private tops: (string | undefined)[];
+private readonly topCounts = new Map<string, number>();
+private symbols: DocumentSymbol[] | undefined;
+private folding: FoldingRange[] | undefined;
+private entries: IndexEntry[] | undefined;
+
+constructor(lines: string[], syntax: LineSyntax[]) {
+this.lines = lines;
+this.syntax = syntax;
+const count = lines.length;
+this.kinds = new Array(count);
+this.parents = new Int32Array(count).fill(-1);
+this.ends = new Int32Array(count);
+this.rawIndents = new Int32Array(count);
+this.tops = new Array(count);
+
+// Open bare keys, innermost last, and the children of each; the root's come first
+const open: number[] = [];
+const children: number[][] = [[]];
+let last = -1;
+// Pair whose raw text block is open, and the tabs its lines start with
+let raw = -1;
+let rawIndent = 0;
+for (let i = 0; i < count; i++) {
+const line = syntax[i];
+if (raw !== -1) {
+// Blank lines belong to the text, but only up to its last non-blank line
+if (line.kind === 'blank') continue;
+if (startsWithTabs(lines[i], rawIndent)) {
+this.rawIndents[i] = rawIndent;
+this.ends[raw] = i;
+last = i;
+continue;
+}
+raw = -1;
+}
+if (line.kind !== 'key' && line.kind !== 'pair') continue;
+while (open.length > 0 && syntax[open[open.length - 1]].indent >= line.indent) {
+this.close(open.pop()!, children.pop()!, last);
+}
+this.parents[i] = open.length > 0 ? open[open.length - 1] : -1;
+children[children.length - 1].push(i);
+this.kinds[i] = line.kind === 'pair' ? 'pair' : 'empty';
+this.ends[i] = i;
+if (line.kind === 'key') {
+open.push(i);
+children.push([]);
+} else if (this.value(i).trim() === rawTextMarker) {
+raw = i;
+rawIndent = line.indent + 1;
+}
+last = i;
+}
+while (open.length > 0) {
+this.close(open.pop()!, children.pop()!, last);
+}
+this.settle(children[0], true);
+for (const child of children[0]) {
+const key = this.topKey(child);
+this.tops[child] = key;
+if (key !== undefined) this.countTop(key, 1);
+}
+}
+
+// Replace the nodes of old lines first..oldEnd - 1 with those of part, a
+// tree of whole top-level blocks that are now lines first onwards. lines
+// and syntax, which this shares with its document, already hold the new
+// lines. Later nodes move by the change in length, and top-level keys whose
+// count crosses one become records or stop being records.
+splice(first: number, oldEnd: number, part: SyntaxTree): void {
+const partLength = part.lines.length;
+const delta = first + partLength - oldEnd;
+const counts = new Map<string, number>();
+const countBefore = (key: string) => {
+if (!counts.has(key)) counts.set(key, this.topCounts.get(key) ?? 0);
+};
+for (let i = first; i < oldEnd; i++) {
+const key = this.tops[i];
+if (key === undefined) continue;
+countBefore(key);
+this.countTop(key, -1);
+}
+for (let i = 0; i < partLength; i++) {
+const key = part.tops[i];
+if (key === undefined) continue;
+countBefore(key);
+this.countTop(key, 1);
+}
+
+replace(this.kinds, first, oldEnd - first, part.kinds);
+replace(this.tops, first, oldEnd - first, part.tops);
+if (delta === 0) {
+this.rawIndents.set(part.rawIndents, first);
+} else {
+const count = this.kinds.length;
+const parents = new Int32Array(count);
+const ends = new Int32Array(count);
+const rawIndents = new Int32Array(count);
+parents.set(this.parents.subarray(0, first));
+ends.set(this.ends.subarray(0, first));
+rawIndents.set(this.rawIndents.subarray(0, first));
+rawIndents.set(part.rawIndents, first);
+rawIndents.set(this.rawIndents.subarray(oldEnd), first + partLength);
+// Only nodes have a parent and an end
+for (let i = oldEnd; i < this.parents.length; i++) {
+const parent = this.parents[i];
+parents[i + delta] = parent === -1 ? -1 : parent + delta;
+if (this.kinds[i + delta] !== undefined) ends[i + delta] = this.ends[i] + delta;
+}
+this.parents = parents;
+this.ends = ends;
+this.rawIndents = rawIndents;
+}
+for (let i = 0; i < partLength; i++) {
+const parent = part.parents[i];
+this.parents[first + i] = parent === -1 ? -1 : parent + first;
+this.ends[first + i] = part.kinds[i] === undefined ? 0 : part.ends[i] + first;
+}
+
+// The part's top-level keys are records if they repeat anywhere; keys
+// elsewhere only change when their count crosses one
+const flipped = new Set<string>();
+for (const [key, before] of counts) {
+if ((before > 1) !== ((this.topCounts.get(key) ?? 0) > 1)) flipped.add(key);
+}
+for (let i = first; i < first + partLength; i++) {
+const key = this.tops[i];
+if (key !== undefined && this.topCounts.get(key)! > 1) this.kinds[i] = 'record';
+}
+if (flipped.size > 0) {
+// Top-level nodes outside the part, skipping over their subtrees
+for (let i = 0; i < this.kinds.length; i++) {
+if (i >= first && i < first + partLength) {
+i = first + partLength - 1;
+continue;
+}
+if (this.kinds[i] === undefined) continue;
+const key = this.tops[i];
+if (key !== undefined && flipped.has(key)) this.settleTop(i, key);
+i = this.ends[i];
+}
+}
+this.symbols = undefined;
+this.folding = undefined;
+this.entries = undefined;
+}
+
+key(node: number): string {
+const syntax = this.syntax[node];
+return this.lines[node].substring(syntax.indent, syntax.keyEnd);
+}
+
+value(node: number): string {
+return this.lines[node].substring(this.syntax[node].valueStart);
+}
+
+documentSymbols(): DocumentSymbol[] {
+if (this.symbols !== undefined) return this.symbols;
+const roots: DocumentSymbol[] = [];
+// Nodes come in document order, so a parent's symbol exists before its children's
+const symbols: (DocumentSymbol | undefined)[] = new Array(this.lines.length);
+for (let i = 0; i < this.lines.length; i++) {
+const kind = this.kinds[i];
+if (kind === undefined) continue;
+const syntax = this.syntax[i];
+const symbol: DocumentSymbol = {
+name: this.key(i),
+kind: symbolKind(kind, syntax.type),
+range: { start: { line: i, character: syntax.indent }, end: { line: this.ends[i], character: this.lines[this.ends[i]].length } },
+selectionRange: { start: { line: i, character: syntax.indent }, end: { line: i, character: syntax.keyEnd } }
+};
+if (kind === 'pair') symbol.detail = this.value(i);
+if (kind !== 'pair' && this.ends[i] > i) symbol.children = [];
+symbols[i] = symbol;
+const parent = this.parents[i];
+(parent === -1 ? roots : symbols[parent]!.children!).push(symbol);
+}
+this.symbols = roots;
+return roots;
+}
+
+foldingRanges(): FoldingRange[] {
+if (this.folding !== undefined) return this.folding;
+const ranges: FoldingRange[] = [];
+let comments = -1;
+for (let i = 0; i <= this.lines.length; i++) {
+const kind = i < this.lines.length && this.rawIndents[i] === 0 ? this.syntax[i].kind : 'blank';
+if (kind === 'comment') {
+if (comments === -1) comments = i;
+continue;
+}
+if (comments !== -1 && i - comments > 1) {
+ranges.push({ startLine: comments, endLine: i - 1, kind: FoldingRangeKind.Comment });
+}
+comments = -1;
+if (i < this.lines.length && this.kinds[i] !== undefined && this.ends[i] > i) {
+ranges.push({ startLine: i, endLine: this.ends[i] });
+}
+}
+this.folding = ranges;
+return ranges;
+}
+
+// Semantic tokens of a line as start, length and type triples. For a tree
+// of part of a document, topKeyCounts gives how often each top-level key
+// with children occurs in the whole document, since repeated ones are records.
+lineTokens(line: number, topKeyCounts?: ReadonlyMap<string, number>): number[] {
+const text = this.lines[line];
+const rawIndent = this.rawIndents[line];
+if (rawIndent > 0) return text.length > rawIndent ? [rawIndent, text.length - rawIndent, stringToken] : noTokens;
+const syntax = this.syntax[line];
+if (syntax.kind === 'comment') return [syntax.indent, syntax.keyEnd - syntax.indent, commentToken];
+const kind = this.kinds[line];
+if (kind === undefined) return noTokens;
+if (kind === 'item') return [syntax.indent, syntax.keyEnd - syntax.indent, valueToken(syntax.type)];
+const topKey = topKeyCounts === undefined ? undefined : this.topKey(line);
+const record = topKey === undefined ? kind === 'record' : topKeyCounts!.get(topKey)! > 1;
+const tokens = [syntax.indent, syntax.keyEnd - syntax.indent, keyToken(record)];
+if (kind === 'pair' && syntax.valueStart < text.length) {
+tokens.push(syntax.valueStart, text.length - syntax.valueStart, valueToken(syntax.type));
+}
+return tokens;
+}
+
+// Key of a top-level bare key with children, which is a record when it repeats
+topKey(line: number): string | undefined {
+if (this.kinds[line] === undefined || this.parents[line] !== -1 || this.syntax[line].kind !== 'key' || this.ends[line] === line) return undefined;
+return this.key(line);
+}
+
+// Each key path once, for the workspace index; list items aren't indexed
+indexEntries(): IndexEntry[] {
+if (this.entries !== undefined) return this.entries;
+const paths: (string | undefined)[] = new Array(this.lines.length);
+const entries = new Map<string, IndexEntry>();
+const types = new Map<string, ValueType | 'mixed'>();
+for (let i = 0; i < this.lines.length; i++) {
+const kind = this.kinds[i];
+if (kind === undefined || kind === 'item') continue;
+const syntax = this.syntax[i];
+const parent = this.parents[i];
+const path = parent === -1 ? this.key(i) : `${paths[parent]}.${this.key(i)}`;
+paths[i] = path;
+const entry = entries.get(path);
+if (entry === undefined) entries.set(path, { path, line: i, start: syntax.indent, end: syntax.keyEnd, kind, count: 1, type: null });
+else entry.count++;
+if (kind === 'pair' && syntax.type !== 'null' && syntax.type !== 'empty') {
+const type = types.get(path);
+if (type === undefined) types.set(path, syntax.type);
+else if (type !== syntax.type) types.set(path, 'mixed');
+}
+}
+for (const [path, type] of types) {
+if (type !== 'mixed') entries.get(path)!.type = type;
+}
+this.entries = Array.from(entries.values());
+return this.entries;
+}
+
+selectionRanges(positions: Position[]): SelectionRange[] {
+return positions.map(position => this.selectionRange(position));
+}
+
+// Ranges from the whole document in to the key or value at the position
+private selectionRange(position: Position): SelectionRange {
+const lastLine = this.lines.length - 1;
+let selection: SelectionRange = { range: this.range(0, 0, lastLine, this.lines[lastLine].length) };
+const narrow = (range: Range) => {
+const outer = selection.range;
+if (range.start.line !== outer.start.line || range.start.character !== outer.start.character ||
+range.end.line !== outer.end.line || range.end.character !== outer.end.character) {
+selection = { range, parent: selection };
+}
+};
+
+const line = Math.min(Math.max(position.line, 0), lastLine);
+const ancestors: number[] = [];
+for (let node = this.enclosing(line); node !== -1; node = this.parents[node]) {
+ancestors.push(node);
+}
+for (let i = ancestors.length - 1; i >= 0; i--) {
+const node = ancestors[i];
+if (this.ends[node] > node) {
+narrow(this.range(node, this.syntax[node].indent, this.ends[node], this.lines[this.ends[node]].length));
+}
+}
+
+const text = this.lines[line];
+if (!text.trim()) return selection;
+const syntax = this.syntax[line];
+if (this.rawIndents[line] > 0) {
+narrow(this.range(line, this.rawIndents[line], line, text.length));
+return selection;
+}
+narrow(this.range(line, syntax.indent, line, text.length));
+if (this.kinds[line] !== undefined && position.character >= syntax.indent) {
+if (position.character <= syntax.keyEnd) narrow(this.range(line, syntax.indent, line, syntax.keyEnd));
+else if (syntax.kind === 'pair' && position.character >= syntax.valueStart) narrow(this.range(line, syntax.valueStart, line, text.length));
+}
+return selection;
+}
+
+// Innermost node whose subtree includes the line, or -1
+private enclosing(line: number): number {
+if (this.kinds[line] !== undefined) return line;
+for (let i = line - 1; i >= 0; i--) {
+if (this.kinds[i] === undefined) continue;
+let node = i;
+while (node !== -1 && this.ends[node] < line) node = this.parents[node];
+return node;
+}
+return -1;
+}
+
+private range(startLine: number, startCharacter: number, endLine: number, endCharacter: number): Range {
+return { start: { line: startLine, character: startCharacter }, end: { line: endLine, character: endCharacter } };
+}
+
+private countTop(key: string, delta: number): void {
+const count = (this.topCounts.get(key) ?? 0) + delta;
+if (count > 0) this.topCounts.set(key, count);
+else this.topCounts.delete(key);
+}
+
+// Kind of a top-level bare key with children: a record when its key repeats,
+// else the kind its children give it
+private settleTop(node: number, key: string): void {
+if (this.topCounts.get(key)! > 1) {
+this.kinds[node] = 'record';
+return;
+}
+const children: number[] = [];
+for (let i = node + 1; i <= this.ends[node]; i++) {
+if (this.kinds[i] !== undefined && this.parents[i] === node) children.push(i);
+}
+this.kinds[node] = this.settle(children, false);
+}
+
+private close(node: number, children: number[], last: number): void {
+this.ends[node] = last;
+if (children.length > 0) this.kinds[node] = this.settle(children, false);
+}
+
+// Kind of a bare key from its children, the same way the parser decides its
+// container; children that are list items or records are marked as such
+private settle(children: number[], root: boolean): NodeKind {
+let pairs = false;
+let items = false;
+// Bare keys with children, and those that repeat; most blocks have none
+let names: Set<string> | undefined;
+let repeated: Set<string> | undefined;
+for (const child of children) {
+if (this.syntax[child].kind === 'pair') {
+pairs = true;
+} else if (this.ends[child] === child) {
+items = true;
+} else {
+const name = this.key(child);
+if (names === undefined) names = new Set();
+if (!names.has(name)) names.add(name);
+else if (repeated === undefined) repeated = new Set([name]);
+else repeated.add(name);
+}
+}
+
+const kind: NodeKind = root ? 'object' : repeated !== undefined ? 'collection' : items && !pairs ? 'list' : 'object';
+for (const child of children) {
+if (this.syntax[child].kind !== 'key') continue;
+if (this.ends[child] === child) {
+if (kind === 'list') this.kinds[child] = 'item';
+} else if (kind === 'collection' || (repeated !== undefined && repeated.has(this.key(child)))) {
+this.kinds[child] = 'record';
+}
+}
+return kind;
+}
+}
+
+// Array splice that doesn't pass large insertions as arguments
+export function replace<T>(array: T[], start: number, deleteCount: number, items: T[]): void {
+if (items.length < 10000) {
+array.splice(start, deleteCount, ...items);
+return;
+}
+const tail = array.slice(start + deleteCount);
+array.length = start;
+for (const item of items) array.push(item);
+for (const item of tail) array.push(item);
+}
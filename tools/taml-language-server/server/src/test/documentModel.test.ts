@@ -0,0 +1,225 @@
+import { test } from 'node:test';
+import * as assert from 'node:assert';
+import { Diagnostic, SemanticTokensEdit } from 'vscode-languageserver/node';
+import { DocumentModel } from '../documentModel';
+import { SyntaxTree } from '../syntaxTree';
+
+// Line, range and message of each diagnostic, for comparing runs
+function summary(diagnostics: Diagnostic[]): string[] {
+return diagnostics.map(d => `${d.range.start.line}:${d.range.start.character}-${d.range.end.character} ${d.severity} ${d.message}`);
+}
+
+// Diagnostics of validating the model's current text from scratch
+function fullValidation(model: DocumentModel, showWarnings: boolean): string[] {
+return summary(new DocumentModel(model.lines.join('\n')).validate(showWarnings));
+}
+
+// Semantic tokens of the model's current text, encoded from a syntax tree of
+// the whole document
+function fullTokens(model: DocumentModel): number[] {
+const tree = new DocumentModel(model.lines.join('\n')).syntaxTree();
+const data: number[] = [];
+let previousLine = 0;
+let previousStart = 0;
+for (let line = 0; line < tree.lines.length; line++) {
+const tokens = tree.lineTokens(line);
+for (let i = 0; i < tokens.length; i += 3) {
+data.push(line - previousLine, line === previousLine ? tokens[i] - previousStart : tokens[i], tokens[i + 1], tokens[i + 2], 0);
+previousLine = line;
+previousStart = tokens[i];
+}
+}
+return data;
+}
+
+function applyEdits(data: number[], edits: SemanticTokensEdit[]): number[] {
+const result = data.slice();
+for (const edit of edits) result.splice(edit.start, edit.deleteCount, ...(edit.data ?? []));
+return result;
+}
+
+// Deterministic random numbers in [0, 1), so failures can be replayed
+function random(seed: number): () => number {
+let state = seed >>> 0;
+return () => {
+state = (state * 1664525 + 1013904223) >>> 0;
+return state / 4294967296;
+};
+}
+
+const pieces = ['key', 'server', 'item', 'user', '\tuser', 'name\t~', 'a  b', 'name\tvalue', 'port\t8080', 'v\tx\ty', '\tx', '# note', '', ' space', '\t \tz', 'raw\t...'];
+
+function randomLines(next: () => number, count: number): string[] {
+const lines: string[] = [];
+for (let i = 0; i < count; i++) {
+lines.push('\t'.repeat(Math.floor(next() * next() * 5)) + pieces[Math.floor(next() * pieces.length)]);
+}
+return lines;
+}
+
+test('validate reports the problems of each line', () => {
+const model = new DocumentModel('server\n\thost\tlocalhost\n\t\tdeep\tvalue\n space');
+assert.deepStrictEqual(summary(model.validate(true)), [
+'2:0-2 1 Indented line has no parent (previous line was not a parent key)',
+'3:0-1 1 Indentation must use tabs, not spaces'
+]);
+});
+
+test('validate merges the ranges of edits made before it runs', () => {
+const model = new DocumentModel('a\n\tb\tv\nc\n\td\te\nf\n\tg\th');
+model.validate(true);
+model.replaceLines(5, 5, ['\t\tg\th']);
+model.replaceLines(1, 1, ['\tb', '\t\tx\ty']);
+model.replaceLines(4, 4, ['\td']);
+assert.deepStrictEqual(summary(model.validate(true)), fullValidation(model, true));
+assert.deepStrictEqual(summary(model.validate(true)), ['6:0-2 1 Invalid indentation level (expected max 1 tabs, found 2)']);
+});
+
+test('validate moves the diagnostics of later lines after inserts and deletes', () => {
+const model = new DocumentModel('a\tb\nc\n\td\te\n space\nf\tg');
+assert.deepStrictEqual(summary(model.validate(true)), ['3:0-1 1 Indentation must use tabs, not spaces']);
+model.replaceLines(0, 0, ['x', '\ty\tz', 'a\tb']);
+assert.deepStrictEqual(summary(model.validate(true)), ['5:0-1 1 Indentation must use tabs, not spaces']);
+model.replaceLines(1, 4, ['c']);
+assert.deepStrictEqual(summary(model.validate(true)), ['2:0-1 1 Indentation must use tabs, not spaces']);
+assert.deepStrictEqual(summary(model.validate(true)), fullValidation(model, true));
+});
+
+test('validate rechecks lines whose parent context changes', () => {
+const model = new DocumentModel('a\tv\n\tb\n\t\tc\td\ne\tf');
+assert.deepStrictEqual(summary(model.validate(true)), ['1:0-1 1 Indented line has no parent (previous line was not a parent key)']);
+// A value line becoming a parent fixes the line after it
+model.replaceLines(0, 0, ['a']);
+assert.deepStrictEqual(summary(model.validate(true)), []);
+// An outdented line changes the context of the unchanged line after it
+model.replaceLines(1, 1, ['b']);
+assert.deepStrictEqual(summary(model.validate(true)), ['2:0-2 1 Invalid indentation level (expected max 1 tabs, found 2)']);
+model.replaceLines(1, 1, ['\tb']);
+assert.deepStrictEqual(summary(model.validate(true)), []);
+});
+
+test('incremental validation matches full validation after random edits', () => {
+for (let seed = 1; seed <= 200; seed++) {
+const next = random(seed);
+const model = new DocumentModel(randomLines(next, 1 + Math.floor(next() * 30)).join('\n'));
+let showWarnings = true;
+for (let round = 0; round < 40; round++) {
+if (next() < 0.03) {
+model.setText(randomLines(next, 1 + Math.floor(next() * 10)).join('\n'));
+}
+// Several edits between validations exercise the dirty range merge
+for (let edits = 1 + Math.floor(next() * 3); edits > 0; edits--) {
+const start = Math.floor(next() * model.lines.length);
+const end = Math.min(model.lines.length - 1, start + Math.floor(next() * next() * 4));
+model.replaceLines(start, end, randomLines(next, 1 + Math.floor(next() * next() * 4)));
+}
+if (next() < 0.1) showWarnings = !showWarnings;
+assert.deepStrictEqual(summary(model.validate(showWarnings)), fullValidation(model, showWarnings), `seed ${seed}, round ${round}`);
+}
+}
+});
+
+// Structure of a syntax tree and the results built from it, for comparing trees
+function treeSummary(tree: SyntaxTree): unknown {
+return {
+kinds: Array.from(tree.kinds),
+parents: Array.from(tree.parents),
+ends: Array.from(tree.ends),
+rawIndents: Array.from(tree.rawIndents),
+symbols: tree.documentSymbols(),
+folding: tree.foldingRanges(),
+entries: tree.indexEntries()
+};
+}
+
+test('the syntax tree kept across edits matches a tree of the whole document', () => {
+for (let seed = 1; seed <= 200; seed++) {
+const next = random(seed);
+const model = new DocumentModel(randomLines(next, 1 + Math.floor(next() * 30)).join('\n'));
+model.syntaxTree();
+for (let round = 0; round < 40; round++) {
+for (let edits = 1 + Math.floor(next() * 3); edits > 0; edits--) {
+const start = Math.floor(next() * model.lines.length);
+const end = Math.min(model.lines.length - 1, start + Math.floor(next() * next() * 4));
+// Some edits only delete lines, as long as one is left
+const count = end - start + 1 < model.lines.length && next() < 0.2 ? 0 : 1 + Math.floor(next() * next() * 4);
+model.replaceLines(start, end, randomLines(next, count));
+}
+const expected = new DocumentModel(model.lines.join('\n')).syntaxTree();
+assert.deepStrictEqual(treeSummary(model.syntaxTree()), treeSummary(expected), `seed ${seed}, round ${round}`);
+}
+}
+});
+
+test('an edit rebuilds only the top-level blocks holding changed lines', () => {
+const model = new DocumentModel('a\n\tb\t1\nc\n\td\t2\ne\n\tf\t3');
+const tree = model.syntaxTree();
+const symbols = tree.documentSymbols();
+model.replaceLines(3, 3, ['\td\t4', '\tg\t5']);
+assert.strictEqual(model.syntaxTree(), tree);
+assert.notStrictEqual(tree.documentSymbols(), symbols);
+assert.deepStrictEqual(tree.documentSymbols().map(s => [s.name, s.range.end.line]), [['a', 1], ['c', 4], ['e', 6]]);
+// Repeating a top-level key makes both records, and removing it undoes that
+model.replaceLines(4, 4, ['a', '\tg\t5']);
+model.syntaxTree();
+assert.deepStrictEqual([tree.kinds[0], tree.kinds[4]], ['record', 'record']);
+model.replaceLines(4, 5, ['\tg\t5']);
+model.syntaxTree();
+assert.strictEqual(tree.kinds[0], 'object');
+});
+
+test('semantic tokens edits match the tokens of the whole document after random edits', () => {
+for (let seed = 1; seed <= 200; seed++) {
+const next = random(seed);
+const model = new DocumentModel(randomLines(next, 1 + Math.floor(next() * 30)).join('\n'));
+let client = model.semanticTokens().data.slice();
+assert.deepStrictEqual(client, fullTokens(model), `seed ${seed}`);
+for (let round = 0; round < 40; round++) {
+if (next() < 0.03) {
+model.setText(randomLines(next, 1 + Math.floor(next() * 10)).join('\n'));
+}
+for (let edits = 1 + Math.floor(next() * 3); edits > 0; edits--) {
+const start = Math.floor(next() * model.lines.length);
+const end = Math.min(model.lines.length - 1, start + Math.floor(next() * next() * 4));
+model.replaceLines(start, end, randomLines(next, 1 + Math.floor(next() * next() * 4)));
+}
+const { data, edits } = model.semanticTokens();
+client = applyEdits(client, edits);
+assert.deepStrictEqual(data, fullTokens(model), `seed ${seed}, round ${round}`);
+assert.deepStrictEqual(client, data, `seed ${seed}, round ${round}`);
+}
+}
+});
+
+test('semantic tokens of repeated top-level keys change with the key count', () => {
+const model = new DocumentModel('user\n\tname\ta\nother\t1\nuser\n\tname\tb');
+const first = model.semanticTokens().data.slice();
+// Both keys are records
+assert.deepStrictEqual([first[3], first[28]], [1, 1]);
+model.replaceLines(3, 4, ['group\t2']);
+const { data, edits } = model.semanticTokens();
+assert.strictEqual(data[3], 0);
+assert.deepStrictEqual(applyEdits(first, edits), data);
+assert.deepStrictEqual(data, fullTokens(model));
+});
+
+test('semantic tokens edits only hold the tokens that changed', () => {
+const lines = ['settings'];
+for (let i = 0; i < 200; i++) lines.push(`\tkey${i}\tvalue`);
+const model = new DocumentModel(lines.join('\n'));
+const before = model.semanticTokens().data.slice();
+// A string value becomes a number, in the middle of one large block
+model.replaceLines(101, 101, ['\tkey100\t42']);
+const { data, edits } = model.semanticTokens();
+assert.deepStrictEqual(applyEdits(before, edits), data);
+assert.deepStrictEqual(data, fullTokens(model));
+// About one line's tokens, of the block's thousand numbers
+assert.strictEqual(edits.length, 1);
+assert.ok(edits[0].deleteCount <= 20 && edits[0].data!.length <= 20, JSON.stringify(edits));
+// Typing in a key adds no tokens, so the edit is one changed length
+model.replaceLines(50, 50, ['\tkey49x\tvalue']);
+const typed = model.semanticTokens().edits;
+assert.deepStrictEqual(applyEdits(data.slice(), typed), fullTokens(model));
+assert.ok(typed[0].deleteCount <= 20 && typed[0].data!.length <= 20, JSON.stringify(typed));
+});
+
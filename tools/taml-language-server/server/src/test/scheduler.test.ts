@@ -0,0 +1,153 @@
+import { afterEach, mock, test } from 'node:test';
+import * as assert from 'node:assert';
+import { ValidationScheduler } from '../scheduler';
+
+const realSetImmediate = setImmediate;
+
+// Replaces the timers the scheduler uses: time only moves in tick(), and
+// setImmediate callbacks run when the test lets the event loop turn
+class FakeTimers {
+private now = 0;
+private nextId = 1;
+private readonly timers = new Map<number, { due: number; callback: () => void }>();
+private immediates: (() => void)[] = [];
+
+constructor() {
+mock.method(globalThis, 'setTimeout', (callback: () => void, delay: number) => {
+const id = this.nextId++;
+this.timers.set(id, { due: this.now + delay, callback });
+return id;
+});
+mock.method(globalThis, 'clearTimeout', (id: number) => {
+this.timers.delete(id);
+});
+mock.method(globalThis, 'setImmediate', (callback: () => void) => {
+this.immediates.push(callback);
+});
+}
+
+// Move the clock forward, firing timers in the order they come due
+async tick(ms: number): Promise<void> {
+const end = this.now + ms;
+for (;;) {
+let next: number | undefined;
+for (const [id, timer] of this.timers) {
+if (timer.due <= end && (next === undefined || timer.due < this.timers.get(next)!.due)) next = id;
+}
+if (next === undefined) break;
+const timer = this.timers.get(next)!;
+this.timers.delete(next);
+this.now = timer.due;
+timer.callback();
+}
+this.now = end;
+await this.settle();
+}
+
+// Settle promise callbacks and run immediates until neither is left
+async settle(): Promise<void> {
+for (;;) {
+await new Promise(resolve => realSetImmediate(resolve));
+if (this.immediates.length === 0) return;
+const immediates = this.immediates;
+this.immediates = [];
+for (const callback of immediates) callback();
+}
+}
+}
+
+// Validation runs that only finish when the test finishes them
+class FakeRuns {
+readonly started: string[] = [];
+readonly tokens: { isCancellationRequested: boolean }[] = [];
+private readonly finishers = new Map<string, () => void>();
+
+readonly run = (uri: string, token: { isCancellationRequested: boolean }): Promise<void> => {
+this.started.push(uri);
+this.tokens.push(token);
+return new Promise(resolve => this.finishers.set(uri, resolve));
+};
+
+finish(uri: string): void {
+const finish = this.finishers.get(uri);
+assert.ok(finish !== undefined, `${uri} is not running`);
+this.finishers.delete(uri);
+finish();
+}
+}
+
+afterEach(() => mock.restoreAll());
+
+test('a document is validated once its delay has passed since the last schedule', async () => {
+const timers = new FakeTimers();
+const runs = new FakeRuns();
+const scheduler = new ValidationScheduler(runs.run, 250);
+scheduler.schedule('a');
+await timers.tick(200);
+scheduler.schedule('a');
+await timers.tick(200);
+assert.deepStrictEqual(runs.started, []);
+await timers.tick(50);
+assert.deepStrictEqual(runs.started, ['a']);
+await timers.tick(1000);
+assert.deepStrictEqual(runs.started, ['a']);
+});
+
+test('cancel drops a pending validation', async () => {
+const timers = new FakeTimers();
+const runs = new FakeRuns();
+const scheduler = new ValidationScheduler(runs.run, 250);
+scheduler.schedule('a');
+scheduler.schedule('b');
+await timers.tick(100);
+scheduler.cancel('a');
+await timers.tick(1000);
+assert.deepStrictEqual(runs.started, ['b']);
+});
+
+test('scheduling a running document cancels the run and starts again after it ends', async () => {
+const timers = new FakeTimers();
+const runs = new FakeRuns();
+const scheduler = new ValidationScheduler(runs.run, 250);
+scheduler.schedule('a');
+await timers.tick(250);
+assert.deepStrictEqual(runs.started, ['a']);
+assert.strictEqual(runs.tokens[0].isCancellationRequested, false);
+
+scheduler.schedule('a');
+assert.strictEqual(runs.tokens[0].isCancellationRequested, true);
+// The new run waits for the cancelled one, so runs of a document don't overlap
+await timers.tick(250);
+assert.deepStrictEqual(runs.started, ['a']);
+runs.finish('a');
+await timers.settle();
+assert.deepStrictEqual(runs.started, ['a', 'a']);
+assert.strictEqual(runs.tokens[1].isCancellationRequested, false);
+});
+
+test('due documents run the active one first, then visible ones, then the rest in order', async () => {
+const timers = new FakeTimers();
+const runs = new FakeRuns();
+const scheduler = new ValidationScheduler(runs.run, 250);
+scheduler.setVisible('d', ['e', 'd']);
+for (const uri of ['a', 'b', 'c', 'd', 'e']) scheduler.schedule(uri);
+await timers.tick(250);
+assert.deepStrictEqual(runs.started, ['d']);
+for (const uri of ['d', 'e', 'a', 'b']) {
+runs.finish(uri);
+await timers.settle();
+}
+assert.deepStrictEqual(runs.started, ['d', 'e', 'a', 'b', 'c']);
+});
+
+test('no more than the given number of validations run at a time', async () => {
+const timers = new FakeTimers();
+const runs = new FakeRuns();
+const scheduler = new ValidationScheduler(runs.run, 250, 2);
+for (const uri of ['a', 'b', 'c']) scheduler.schedule(uri);
+await timers.tick(250);
+assert.deepStrictEqual(runs.started, ['a', 'b']);
+runs.finish('b');
+await timers.settle();
+assert.deepStrictEqual(runs.started, ['a', 'b', 'c']);
+});
@@ -0,0 +1,78 @@
+import { test } from 'node:test';
+import * as assert from 'node:assert';
+import { SyntaxTree, parseLine } from '../syntaxTree';
+import { DocumentModel, splitLines } from '../documentModel';
+
+function tree(text: string): SyntaxTree {
+const lines = splitLines(text);
+return new SyntaxTree(lines, lines.map(parseLine));
+}
+
+// A raw text block inside an object, whose text looks like comments, keys
+// and another raw text block
+const nestedRaw = [
+'server',
+'\thost\tlocalhost',
+'\tscript\t...',
+'\t\t# not a comment',
+'\t\techo\thello',
+'\t\t\tnested\t...',
+'',
+'\t\tkey',
+'',
+'\tport\t8080',
+'notes\t...',
+'\tline'
+].join('\n');
+
+test('raw text lines are not nodes', () => {
+const syntax = tree(nestedRaw);
+assert.deepStrictEqual(Array.from(syntax.rawIndents), [0, 0, 0, 2, 2, 2, 0, 2, 0, 0, 0, 1]);
+assert.deepStrictEqual(Array.from(syntax.kinds), ['object', 'pair', 'pair', undefined, undefined, undefined, undefined, undefined, undefined, 'pair', 'pair', undefined]);
+assert.deepStrictEqual(Array.from(syntax.parents).filter((_, i) => syntax.kinds[i] !== undefined), [-1, 0, 0, 0, -1]);
+assert.strictEqual(syntax.ends[2], 7);
+assert.strictEqual(syntax.ends[0], 9);
+assert.strictEqual(syntax.ends[10], 11);
+});
+
+test('raw text blocks are part of their pair in symbols and folding', () => {
+const syntax = tree(nestedRaw);
+const [server, notes] = syntax.documentSymbols();
+assert.deepStrictEqual(server.children!.map(symbol => symbol.name), ['host', 'script', 'port']);
+const script = server.children![1];
+assert.strictEqual(script.children, undefined);
+assert.deepStrictEqual(script.range, { start: { line: 2, character: 1 }, end: { line: 7, character: 5 } });
+assert.strictEqual(notes.children, undefined);
+assert.deepStrictEqual(syntax.foldingRanges(), [{ startLine: 0, endLine: 9 }, { startLine: 2, endLine: 7 }, { startLine: 10, endLine: 11 }]);
+});
+
+test('raw text is a string token without its structural indentation', () => {
+const data = new DocumentModel(nestedRaw).semanticTokens().data;
+const tokens: number[][] = [];
+let line = 0;
+let start = 0;
+for (let i = 0; i < data.length; i += 5) {
+line += data[i];
+start = data[i] === 0 ? start + data[i + 1] : data[i + 1];
+tokens.push([line, start, data[i + 2], data[i + 3]]);
+}
+assert.deepStrictEqual(tokens.filter(([tokenLine]) => tokenLine >= 3 && tokenLine <= 7), [
+[3, 2, 15, 2],
+[4, 2, 10, 2],
+[5, 2, 11, 2],
+[7, 2, 3, 2]
+]);
+assert.deepStrictEqual(tokens.filter(([tokenLine]) => tokenLine === 11), [[11, 1, 4, 2]]);
+});
+
+test('raw text lines are not indexed as key paths', () => {
+const entries = tree(nestedRaw).indexEntries();
+assert.deepStrictEqual(entries.map(entry => entry.path), ['server', 'server.host', 'server.script', 'server.port', 'notes']);
+assert.strictEqual(entries[2].type, 'string');
+});
+
+test('a raw text block ends at the first line indented less than its text', () => {
+const syntax = tree('list\n\titem\t...\n\t\ttext\n\tother\n\tmore');
+assert.deepStrictEqual(Array.from(syntax.kinds), ['object', 'pair', undefined, 'empty', 'empty']);
+assert.deepStrictEqual(syntax.selectionRanges([{ line: 2, character: 3 }])[0].range, { start: { line: 2, character: 2 }, end: { line: 2, character: 6 } });
+});
@@ -0,0 +1,94 @@
+import { test } from 'node:test';
+import * as assert from 'node:assert';
+import { Diagnostic, Position, SemanticTokens } from 'vscode-languageserver/node';
+import { WorkerPool } from '../workerPool';
+
+function messages(diagnostics: Diagnostic[]): string[] {
+return diagnostics.map(d => `${d.range.start.line} ${d.message}`);
+}
+
+// Runs body with a pool that reads the current text of each open document
+// from `texts`, as the server keeps it
+async function withPool(size: number, body: (pool: WorkerPool, texts: Map<string, string>) => Promise<void>): Promise<void> {
+const texts = new Map<string, string>();
+const pool = new WorkerPool(size, uri => texts.get(uri));
+// The workers don't keep the process alive; in the server the connection does
+const keepAlive = setInterval(() => undefined, 1000);
+try {
+await body(pool, texts);
+} finally {
+clearInterval(keepAlive);
+pool.dispose();
+}
+}
+
+// Positions the worker can't read, so answering the query throws and the
+// worker exits
+const crashingPositions = null as unknown as Position[];
+
+test('each document stays on one worker, which sees its edits in order', () => withPool(2, async (pool, texts) => {
+texts.set('a', 'a\n  b');
+texts.set('b', 'b\tv');
+pool.open('a', texts.get('a')!);
+pool.open('b', texts.get('b')!);
+assert.notStrictEqual(pool['assigned'].get('a'), pool['assigned'].get('b'));
+
+assert.deepStrictEqual(messages(await pool.validate('a', true)), ['1 Indentation must use tabs, not spaces']);
+pool.edit('a', [{ start: 1, oldEnd: 1, lines: ['\tb'] }]);
+const fixed = pool.validate('a', true);
+pool.edit('a', [{ text: 'x\n  y\n  z' }]);
+// Each query sees exactly the edits posted before it
+assert.deepStrictEqual(messages(await fixed), []);
+assert.deepStrictEqual(messages(await pool.validate('a', true)), [
+'1 Indentation must use tabs, not spaces',
+'2 Indentation must use tabs, not spaces'
+]);
+}));
+
+test('queries for a closed document get the empty answer', () => withPool(1, async pool => {
+pool.open('a', 'a\n  b');
+pool.close('a');
+assert.deepStrictEqual(await pool.validate('a', true), []);
+assert.deepStrictEqual(await pool.documentSymbols('a'), []);
+}));
+
+test('a crashed worker is replaced and its documents reopened from their current text', () => withPool(2, async (pool, texts) => {
+for (const uri of ['a', 'b', 'c']) {
+texts.set(uri, `${uri}\n  x`);
+pool.open(uri, texts.get(uri)!);
+}
+const crashed = pool['assigned'].get('a')!;
+const other = pool['workers'].find(pooled => pooled !== crashed)!;
+texts.set('a', 'a\n\tx');
+pool.edit('a', [{ start: 1, oldEnd: 1, lines: ['\tx'] }]);
+// Closed by the server while the worker was down; it has no text to reopen
+const closedMeanwhile = [...crashed.documents].find(uri => uri !== 'a');
+if (closedMeanwhile !== undefined) texts.delete(closedMeanwhile);
+
+// A query that was pending on the worker fails rather than waiting forever
+await assert.rejects(pool.selectionRanges('a', crashingPositions));
+assert.strictEqual(pool.size, 2);
+assert.ok(!pool['workers'].includes(crashed));
+assert.ok(pool['workers'].includes(other));
+
+assert.deepStrictEqual(messages(await pool.validate('a', true)), []);
+for (const uri of ['b', 'c']) {
+const expected = uri === closedMeanwhile ? [] : ['1 Indentation must use tabs, not spaces'];
+assert.deepStrictEqual(messages(await pool.validate(uri, true)), expected, uri);
+}
+}));
+
+test('semantic tokens results from a crashed worker are not used for deltas', () => withPool(1, async (pool, texts) => {
+texts.set('a', 'a\tb');
+pool.open('a', texts.get('a')!);
+const first = await pool.semanticTokens('a');
+assert.ok(first.resultId !== undefined && first.data.length > 0);
+assert.ok('edits' in await pool.semanticTokensDelta('a', first.resultId));
+
+const previous = await pool.semanticTokens('a');
+await assert.rejects(pool.selectionRanges('a', crashingPositions));
+// The replacement worker never sent that result, so it sends all tokens
+const after = await pool.semanticTokensDelta('a', previous.resultId!) as SemanticTokens;
+assert.deepStrictEqual(after.data, first.data);
+assert.notStrictEqual(after.resultId, previous.resultId);
+}));
@@ -0,0 +1,143 @@
+import { test } from 'node:test';
+import * as assert from 'node:assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { pathToFileURL } from 'url';
+import { DocumentModel } from '../documentModel';
+import { WorkspaceIndex } from '../workspaceIndex';
+
+// An index that indexes text on the calling thread, as the workers do, and
+// records the texts it was asked to index
+function createIndex(indexed: string[] = []): WorkspaceIndex {
+return new WorkspaceIndex(async text => {
+indexed.push(text);
+return new DocumentModel(text).syntaxTree().indexEntries();
+}, () => undefined);
+}
+
+// Runs body with a workspace folder holding the given files and a separate
+// storage folder for the cache, removing both afterwards
+async function withWorkspace(files: Record<string, string>, body: (folder: string, storage: string) => Promise<void>): Promise<void> {
+const root = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'taml-index-'));
+const folder = path.join(root, 'workspace');
+const storage = path.join(root, 'storage');
+try {
+for (const [name, text] of Object.entries(files)) {
+const file = path.join(folder, name);
+await fs.promises.mkdir(path.dirname(file), { recursive: true });
+await fs.promises.writeFile(file, text);
+}
+await body(folder, storage);
+} finally {
+await fs.promises.rm(root, { recursive: true, force: true });
+}
+}
+
+// Cross-file warnings for a document of the given text at file
+function warnings(index: WorkspaceIndex, file: string, text: string): string[] {
+const entries = new DocumentModel(text).syntaxTree().indexEntries();
+return index.crossFileDiagnostics(pathToFileURL(file).href, entries).map(d => `${d.range.start.line} ${d.message}`);
+}
+
+// The index's type counts when each key path has one file of the given type
+function typeCounts(types: Record<string, string>): Map<string, Map<string, number>> {
+return new Map(Object.entries(types).map(([key, type]) => [key, new Map([[type, 1]])]));
+}
+
+test('the scan skips hidden and dependency directories and files that are not .taml', () => withWorkspace({
+'a.taml': 'a\t1',
+'sub/b.taml': 'b\t1',
+'node_modules/c.taml': 'c\t1',
+'sub/out/d.taml': 'd\t1',
+'.git/e.taml': 'e\t1',
+'.hidden.taml': 'f\t1',
+'g.txt': 'g\t1'
+}, async (folder, storage) => {
+const index = createIndex();
+await index.start([folder], storage);
+assert.strictEqual(index.size, 2);
+assert.deepStrictEqual(index.symbols('').map(s => s.name).sort(), ['a', 'b']);
+
+// File events for the same files are ignored, as the scan would not find them
+for (const name of ['node_modules/c.taml', 'sub/out/d.taml', '.git/e.taml', 'g.txt']) {
+await index.update(path.join(folder, name));
+}
+await index.update(path.join(path.dirname(folder), 'elsewhere.taml'));
+assert.strictEqual(index.size, 2);
+// A file that can't be read is left out
+await index.update(path.join(folder, 'sub/missing.taml'));
+assert.strictEqual(index.size, 2);
+}));
+
+test('workspace symbols match the query characters in order', () => withWorkspace({
+'config.taml': 'server\n\thost\tlocalhost\n\tport\t8080\nuser\n\tname\ta\nuser\n\tname\tb'
+}, async (folder, storage) => {
+const index = createIndex();
+await index.start([folder], storage);
+const names = (query: string) => index.symbols(query).map(s => `${s.containerName ?? ''}/${s.name}`);
+assert.deepStrictEqual(names('sp'), ['server/port']);
+assert.deepStrictEqual(names('SERVERHOST'), ['server/host']);
+assert.deepStrictEqual(names('tsoh'), []);
+assert.deepStrictEqual(names('user'), ['/user (2 records)', 'user/name']);
+}));
+
+test('a value is warned about when at least two other files agree on another type', () => withWorkspace({
+'a.taml': 'port\t80',
+'b.taml': 'port\t81',
+'c.taml': 'port\t82\nname\tx',
+'d.taml': 'name\t1\nhost\tx'
+}, async (folder, storage) => {
+const index = createIndex();
+await index.start([folder], storage);
+const outside = path.join(folder, 'new.taml');
+assert.deepStrictEqual(warnings(index, outside, 'port\tx'), ["0 'port' is a string here, but a number in 3 other files"]);
+assert.deepStrictEqual(warnings(index, outside, 'port\t1'), []);
+// One other file is not enough to say which of the two is wrong
+assert.deepStrictEqual(warnings(index, outside, 'host\t1'), []);
+assert.deepStrictEqual(warnings(index, outside, 'name\ttrue'), []);
+
+// The document's saved version doesn't count as another file
+const own = path.join(folder, 'c.taml');
+assert.deepStrictEqual(warnings(index, own, 'port\tx'), ["0 'port' is a string here, but a number in 2 other files"]);
+await fs.promises.writeFile(path.join(folder, 'b.taml'), 'port\tx');
+await index.update(path.join(folder, 'b.taml'));
+assert.deepStrictEqual(warnings(index, own, 'port\tx'), []);
+
+// Once the other files disagree among themselves, nothing is warned about
+index.remove(path.join(folder, 'b.taml'));
+await fs.promises.writeFile(path.join(folder, 'e.taml'), 'port\ttrue\nport\tfalse');
+await index.update(path.join(folder, 'e.taml'));
+await fs.promises.writeFile(path.join(folder, 'f.taml'), 'port\tyes');
+await index.update(path.join(folder, 'f.taml'));
+assert.deepStrictEqual(warnings(index, outside, 'port\tx'), []);
+}));
+
+test('a restart reads only the files that changed since the cache was saved', () => withWorkspace({
+'a.taml': 'a\t1',
+'b.taml': 'b\t1',
+'c.taml': 'c\t1'
+}, async (folder, storage) => {
+const first = createIndex();
+await first.start([folder], storage);
+await first['save']();
+
+const indexed: string[] = [];
+const second = createIndex(indexed);
+await fs.promises.writeFile(path.join(folder, 'b.taml'), 'b\ttrue');
+await fs.promises.rm(path.join(folder, 'c.taml'));
+await second.start([folder], storage);
+assert.deepStrictEqual(indexed, ['b\ttrue']);
+assert.deepStrictEqual(second.symbols('').map(s => s.name).sort(), ['a', 'b']);
+// Entries from the cache count toward type warnings like freshly read ones
+assert.deepStrictEqual(second['types'], typeCounts({ a: 'number', b: 'boolean' }));
+
+// A cache written by another version is ignored
+const [cacheFile] = await fs.promises.readdir(storage);
+const data = JSON.parse(await fs.promises.readFile(path.join(storage, cacheFile), 'utf8'));
+data.version = -1;
+await fs.promises.writeFile(path.join(storage, cacheFile), JSON.stringify(data));
+indexed.length = 0;
+await createIndex(indexed).start([folder], storage);
+assert.deepStrictEqual(indexed.sort(), ['a\t1', 'b\ttrue']);
+}));
@@ -0,0 +1,73 @@
+import { parentPort, threadId } from 'worker_threads';
+import {
+SemanticTokens,
+SemanticTokensDelta
+} from 'vscode-languageserver/node';
+import { DocumentModel } from './documentModel';
+import { WorkerQuery, WorkerRequest, WorkerResponse } from './workerProtocol';
+
+// Line models of the documents assigned to this worker
+const models = new Map<string, DocumentModel>();
+
+// Result id of the semantic tokens last sent for each document, which the next
+// delta is taken from
+const sentTokens = new Map<string, string>();
+let nextResultId = 0;
+
+parentPort!.on('message', (request: WorkerRequest) => {
+switch (request.kind) {
+case 'open':
+models.set(request.uri, new DocumentModel(request.text));
+sentTokens.delete(request.uri);
+break;
+case 'edit': {
+const model = models.get(request.uri);
+if (!model) break;
+for (const edit of request.edits) {
+if ('text' in edit) model.setText(edit.text);
+else model.replaceLines(edit.start, edit.oldEnd, edit.lines);
+}
+break;
+}
+case 'close':
+models.delete(request.uri);
+sentTokens.delete(request.uri);
+break;
+case 'query': {
+const model = models.get(request.uri);
+const response: WorkerResponse = { id: request.id, result: JSON.stringify(model ? answer(request.uri, model, request.query) : null) };
+parentPort!.postMessage(response);
+break;
+}
+case 'indexText': {
+const response: WorkerResponse = { id: request.id, result: JSON.stringify(new DocumentModel(request.text).syntaxTree().indexEntries()) };
+parentPort!.postMessage(response);
+break;
+}
+}
+});
+
+function answer(uri: string, model: DocumentModel, query: WorkerQuery): unknown {
+switch (query.kind) {
+case 'validate': return model.validate(query.showWarnings);
+case 'documentSymbols': return model.syntaxTree().documentSymbols();
+case 'foldingRanges': return model.syntaxTree().foldingRanges();
+case 'selectionRanges': return model.syntaxTree().selectionRanges(query.positions);
+case 'semanticTokens': return semanticTokens(uri, model, undefined);
+case 'semanticTokensDelta': return semanticTokens(uri, model, query.previousResultId);
+case 'indexEntries': return model.syntaxTree().indexEntries();
+}
+}
+
+function semanticTokens(uri: string, model: DocumentModel, previousResultId: string | undefined): SemanticTokens | SemanticTokensDelta {
+// The model's edits turn the tokens it last returned, which were sent, into these
+const { data, edits } = model.semanticTokens();
+const previous = sentTokens.get(uri);
+// Result ids include the thread, so none is reused by a replacement worker
+const resultId = `${threadId}.${++nextResultId}`;
+sentTokens.set(uri, resultId);
+if (previous !== undefined && previous === previousResultId) {
+return { resultId, edits };
+}
+return { resultId, data };
+}
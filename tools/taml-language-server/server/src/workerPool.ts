@@ -0,0 +1,170 @@
+import * as path from 'path';
+import { Worker } from 'worker_threads';
+import {
+Diagnostic,
+DocumentSymbol,
+FoldingRange,
+Position,
+SelectionRange,
+SemanticTokens,
+SemanticTokensDelta
+} from 'vscode-languageserver/node';
+import { IndexEntry } from './syntaxTree';
+import { LineEdit, WorkerQuery, WorkerRequest, WorkerResponse } from './workerProtocol';
+
+interface PendingQuery {
+resolve(result: unknown): void;
+reject(error: Error): void;
+}
+
+interface PooledWorker {
+worker: Worker;
+documents: Set<string>;
+pending: Map<number, PendingQuery>;
+}
+
+// Worker threads that hold the models of the open documents, and validate
+// them and answer structure requests off the LSP thread. Each document stays on one worker, which receives
+// its text when opened and only the changed lines after that. A worker that
+// dies is replaced, and its documents are reopened from their current text.
+export class WorkerPool {
+private readonly workers: PooledWorker[] = [];
+private readonly assigned = new Map<string, PooledWorker>();
+private readonly getText: (uri: string) => string | undefined;
+private nextId = 0;
+private nextIndexer = 0;
+private disposed = false;
+
+constructor(size: number, getText: (uri: string) => string | undefined) {
+this.getText = getText;
+for (let i = 0; i < size; i++) {
+this.workers.push(this.spawn());
+}
+}
+
+get size(): number {
+return this.workers.length;
+}
+
+open(uri: string, text: string): void {
+this.close(uri);
+let target = this.workers[0];
+for (const pooled of this.workers) {
+if (pooled.documents.size < target.documents.size) target = pooled;
+}
+this.assign(uri, target, text);
+}
+
+edit(uri: string, edits: LineEdit[]): void {
+this.post(uri, { kind: 'edit', uri, edits });
+}
+
+close(uri: string): void {
+const pooled = this.assigned.get(uri);
+if (!pooled) return;
+this.post(uri, { kind: 'close', uri });
+pooled.documents.delete(uri);
+this.assigned.delete(uri);
+}
+
+// Diagnostics of the document as of the edits sent so far
+validate(uri: string, showWarnings: boolean): Promise<Diagnostic[]> {
+return this.query<Diagnostic[]>(uri, { kind: 'validate', showWarnings }, []);
+}
+
+documentSymbols(uri: string): Promise<DocumentSymbol[]> {
+return this.query<DocumentSymbol[]>(uri, { kind: 'documentSymbols' }, []);
+}
+
+foldingRanges(uri: string): Promise<FoldingRange[]> {
+return this.query<FoldingRange[]>(uri, { kind: 'foldingRanges' }, []);
+}
+
+selectionRanges(uri: string, positions: Position[]): Promise<SelectionRange[]> {
+return this.query<SelectionRange[]>(uri, { kind: 'selectionRanges', positions }, []);
+}
+
+semanticTokens(uri: string): Promise<SemanticTokens> {
+return this.query<SemanticTokens>(uri, { kind: 'semanticTokens' }, { data: [] });
+}
+
+// The edits since previousResultId when the worker still knows it, else all tokens
+semanticTokensDelta(uri: string, previousResultId: string): Promise<SemanticTokens | SemanticTokensDelta> {
+return this.query<SemanticTokens | SemanticTokensDelta>(uri, { kind: 'semanticTokensDelta', previousResultId }, { data: [] });
+}
+
+indexEntries(uri: string): Promise<IndexEntry[]> {
+return this.query<IndexEntry[]>(uri, { kind: 'indexEntries' }, []);
+}
+
+// Index entries of text that isn't an open document, on each worker in turn
+indexText(text: string): Promise<IndexEntry[]> {
+const pooled = this.workers[this.nextIndexer++ % this.workers.length];
+const id = ++this.nextId;
+return new Promise((resolve, reject) => {
+pooled.pending.set(id, { resolve: result => resolve(result as IndexEntry[]), reject });
+pooled.worker.postMessage({ kind: 'indexText', id, text } as WorkerRequest);
+});
+}
+
+dispose(): void {
+this.disposed = true;
+for (const pooled of this.workers) {
+pooled.worker.terminate();
+}
+}
+
+private query<T>(uri: string, query: WorkerQuery, fallback: T): Promise<T> {
+const pooled = this.assigned.get(uri);
+if (!pooled) return Promise.resolve(fallback);
+const id = ++this.nextId;
+return new Promise((resolve, reject) => {
+pooled.pending.set(id, { resolve: result => resolve(result === null ? fallback : result as T), reject });
+pooled.worker.postMessage({ kind: 'query', id, uri, query } as WorkerRequest);
+});
+}
+
+private post(uri: string, request: WorkerRequest): void {
+this.assigned.get(uri)?.worker.postMessage(request);
+}
+
+private assign(uri: string, pooled: PooledWorker, text: string): void {
+this.assigned.set(uri, pooled);
+pooled.documents.add(uri);
+pooled.worker.postMessage({ kind: 'open', uri, text } as WorkerRequest);
+}
+
+private spawn(): PooledWorker {
+const worker = new Worker(path.join(__dirname, 'worker.js'));
+const pooled: PooledWorker = { worker, documents: new Set(), pending: new Map() };
+let failure: Error | undefined;
+worker.on('message', (response: WorkerResponse) => {
+const pending = pooled.pending.get(response.id);
+if (!pending) return;
+pooled.pending.delete(response.id);
+pending.resolve(JSON.parse(response.result));
+});
+worker.on('error', error => {
+failure = error;
+});
+worker.on('exit', code => {
+if (!this.disposed) this.replace(pooled, failure ?? new Error(`Validation worker exited with code ${code}`));
+});
+// The connection decides when the server exits, not the workers
+worker.unref();
+return pooled;
+}
+
+private replace(pooled: PooledWorker, error: Error): void {
+for (const pending of pooled.pending.values()) {
+pending.reject(error);
+}
+const fresh = this.spawn();
+this.workers[this.workers.indexOf(pooled)] = fresh;
+for (const uri of pooled.documents) {
+const text = this.getText(uri);
+if (text === undefined) this.assigned.delete(uri);
+else this.assign(uri, fresh, text);
+}
+}
+}
@@ -0,0 +1,34 @@
+import { Position } from 'vscode-languageserver/node';
+
+// Lines start..oldEnd (inclusive) replaced by `lines`, or the whole text replaced
+export type LineEdit =
+| { start: number; oldEnd: number; lines: string[] }
+| { text: string };
+
+// Questions about a document, answered with a WorkerResponse
+export type WorkerQuery =
+| { kind: 'validate'; showWarnings: boolean }
+| { kind: 'documentSymbols' }
+| { kind: 'foldingRanges' }
+| { kind: 'selectionRanges'; positions: Position[] }
+| { kind: 'semanticTokens' }
+// Edits from the given result when the worker still has it, else all tokens
+| { kind: 'semanticTokensDelta'; previousResultId: string }
+| { kind: 'indexEntries' };
+
+// Messages from the server to a worker. A worker handles them in the order they
+// were posted, so a query always sees every edit sent before it.
+export type WorkerRequest =
+| { kind: 'open'; uri: string; text: string }
+| { kind: 'edit'; uri: string; edits: LineEdit[] }
+| { kind: 'close'; uri: string }
+| { kind: 'query'; id: number; uri: string; query: WorkerQuery }
+// Index entries of a file that isn't open, answered like a query
+| { kind: 'indexText'; id: number; text: string };
+
+// Reply to a query as JSON, null for unknown documents. Large results parse from JSON several times faster than
+// they deserialize from a structured clone.
+export interface WorkerResponse {
+id: number;
+result: string;
+}
@@ -0,0 +1,281 @@
+import * as fs from 'fs';
+import * as path from 'path';
+import { createHash } from 'crypto';
+import { fileURLToPath, pathToFileURL } from 'url';
+import {
+Diagnostic,
+DiagnosticSeverity,
+SymbolInformation
+} from 'vscode-languageserver/node';
+import { IndexEntry, ValueType, symbolKind } from './syntaxTree';
+
+interface FileIndex {
+mtime: number;
+size: number;
+entries: IndexEntry[];
+}
+
+// Bump when IndexEntry or the way entries are built changes
+const cacheVersion = 1;
+
+// Directories that hold dependencies or build output rather than workspace files
+const skippedDirectories = new Set(['node_modules', 'bin', 'obj', 'out']);
+
+// Files read and indexed at a time while the workspace is scanned
+const indexConcurrency = 8;
+
+// Workspace symbol results are capped; the editor filters them further as the user types
+const maxSymbols = 500;
+
+// Key paths of every .taml file in the workspace folders. Files are indexed
+// on the worker threads, kept up to date from file events, and saved to a
+// cache file so that unchanged files aren't read again on the next start.
+export class WorkspaceIndex {
+private readonly files = new Map<string, FileIndex>();
+// For each key path, the number of files whose values for it have each type
+private readonly types = new Map<string, Map<ValueType, number>>();
+private readonly indexText: (text: string) => Promise<IndexEntry[]>;
+private readonly onChange: () => void;
+private folders: string[] = [];
+private cacheFile: string | undefined;
+private saveTimer: NodeJS.Timeout | undefined;
+
+constructor(indexText: (text: string) => Promise<IndexEntry[]>, onChange: () => void) {
+this.indexText = indexText;
+this.onChange = onChange;
+}
+
+// Number of indexed files
+get size(): number {
+return this.files.size;
+}
+
+async start(folders: string[], storagePath: string): Promise<void> {
+this.folders = folders;
+const name = createHash('sha1').update(folders.join('\n')).digest('hex').slice(0, 16);
+this.cacheFile = path.join(storagePath, `taml-index-${name}.json`);
+const cached = await this.loadCache();
+
+const stale: string[] = [];
+for (const folder of folders) {
+for await (const file of findTamlFiles(folder)) {
+const stat = await fs.promises.stat(file).catch(() => undefined);
+if (!stat) continue;
+const index = cached.get(file);
+if (index && index.mtime === stat.mtimeMs && index.size === stat.size) this.add(file, index);
+else stale.push(file);
+}
+}
+if (this.files.size > 0) this.onChange();
+
+let next = 0;
+const indexNext = async (): Promise<void> => {
+while (next < stale.length) {
+await this.update(stale[next++], false);
+}
+};
+await Promise.all(Array.from({ length: indexConcurrency }, indexNext));
+if (stale.length > 0 || cached.size !== this.files.size) {
+this.onChange();
+this.scheduleSave();
+}
+}
+
+// Reindex a created or changed file, or drop it if it can't be read
+async update(file: string, notify = true): Promise<void> {
+if (!this.isIndexed(file)) return;
+try {
+const stat = await fs.promises.stat(file);
+const text = await fs.promises.readFile(file, 'utf8');
+this.add(file, { mtime: stat.mtimeMs, size: stat.size, entries: await this.indexText(text) });
+} catch {
+this.remove(file, false);
+}
+if (notify) {
+this.onChange();
+this.scheduleSave();
+}
+}
+
+remove(file: string, notify = true): void {
+const index = this.files.get(file);
+if (!index) return;
+this.count(index, -1);
+this.files.delete(file);
+if (notify) {
+this.onChange();
+this.scheduleSave();
+}
+}
+
+// Key paths whose name or path contains the query's characters in order
+symbols(query: string): SymbolInformation[] {
+const needle = query.toLowerCase();
+const symbols: SymbolInformation[] = [];
+for (const [file, index] of this.files) {
+const uri = pathToFileURL(file).href;
+for (const entry of index.entries) {
+if (!matches(entry.path.toLowerCase(), needle)) continue;
+const dot = entry.path.lastIndexOf('.');
+const key = entry.path.substring(dot + 1);
+symbols.push({
+name: entry.kind === 'record' && entry.count > 1 ? `${key} (${entry.count} records)` : key,
+kind: symbolKind(entry.kind, entry.type ?? 'string'),
+location: { uri, range: { start: { line: entry.line, character: entry.start }, end: { line: entry.line, character: entry.end } } },
+containerName: dot === -1 ? undefined : entry.path.substring(0, dot)
+});
+if (symbols.length >= maxSymbols) return symbols;
+}
+}
+return symbols;
+}
+
+// Warnings for values whose type differs from the one every other file
+// that has the key path uses, given the document's current entries
+crossFileDiagnostics(uri: string, entries: IndexEntry[]): Diagnostic[] {
+const own = uri.startsWith('file:') ? this.files.get(fileURLToPath(uri)) : undefined;
+const ownTypes = new Map<string, ValueType>();
+for (const entry of own?.entries ?? []) {
+if (entry.type !== null) ownTypes.set(entry.path, entry.type);
+}
+
+const diagnostics: Diagnostic[] = [];
+for (const entry of entries) {
+if (entry.type === null) continue;
+const counts = this.types.get(entry.path);
+if (!counts) continue;
+let other: ValueType | undefined;
+let files = 0;
+for (const [type, count] of counts) {
+const others = count - (ownTypes.get(entry.path) === type ? 1 : 0);
+if (others === 0) continue;
+if (other !== undefined) {
+other = undefined;
+break;
+}
+other = type;
+files = others;
+}
+if (other === undefined || other === entry.type || files < 2) continue;
+diagnostics.push({
+severity: DiagnosticSeverity.Warning,
+range: { start: { line: entry.line, character: entry.start }, end: { line: entry.line, character: entry.end } },
+message: `'${entry.path}' is ${describe(entry.type)} here, but ${describe(other)} in ${files} other files`,
+source: 'taml'
+});
+}
+return diagnostics;
+}
+
+// Whether a file is one the scan would find: a .taml file in a workspace
+// folder, outside hidden and skipped directories
+private isIndexed(file: string): boolean {
+if (!file.endsWith('.taml')) return false;
+return this.folders.some(folder => {
+const relative = path.relative(folder, file);
+if (relative.startsWith('..') || path.isAbsolute(relative)) return false;
+return !relative.split(path.sep).some(part => part.startsWith('.') || skippedDirectories.has(part));
+});
+}
+
+private add(file: string, index: FileIndex): void {
+const previous = this.files.get(file);
+if (previous) this.count(previous, -1);
+this.files.set(file, index);
+this.count(index, 1);
+}
+
+private count(index: FileIndex, delta: number): void {
+for (const entry of index.entries) {
+if (entry.type === null) continue;
+let counts = this.types.get(entry.path);
+if (!counts) {
+counts = new Map();
+this.types.set(entry.path, counts);
+}
+const count = (counts.get(entry.type) ?? 0) + delta;
+if (count > 0) counts.set(entry.type, count);
+else counts.delete(entry.type);
+if (counts.size === 0) this.types.delete(entry.path);
+}
+}
+
+private async loadCache(): Promise<Map<string, FileIndex>> {
+const cached = new Map<string, FileIndex>();
+try {
+const data = JSON.parse(await fs.promises.readFile(this.cacheFile!, 'utf8'));
+if (data.version === cacheVersion) {
+for (const [file, index] of Object.entries(data.files)) {
+cached.set(file, index as FileIndex);
+}
+}
+} catch {
+// No cache yet, or an unreadable one: index everything
+}
+return cached;
+}
+
+// Changes come in bursts, such as a branch switch, so writes are batched
+private scheduleSave(): void {
+if (this.saveTimer !== undefined || this.cacheFile === undefined) return;
+this.saveTimer = setTimeout(() => {
+this.saveTimer = undefined;
+this.save();
+}, 2000);
+this.saveTimer.unref();
+}
+
+private async save(): Promise<void> {
+const cacheFile = this.cacheFile!;
+const data = { version: cacheVersion, files: Object.fromEntries(this.files) };
+try {
+await fs.promises.mkdir(path.dirname(cacheFile), { recursive: true });
+// Written beside the cache and renamed over it, so a reader never sees half a file
+const temporary = `${cacheFile}.${process.pid}.tmp`;
+await fs.promises.writeFile(temporary, JSON.stringify(data));
+await fs.promises.rename(temporary, cacheFile);
+} catch {
+// The cache only saves time; the index itself is still complete
+}
+}
+}
+
+async function* findTamlFiles(folder: string): AsyncGenerator<string> {
+const pending = [folder];
+while (pending.length > 0) {
+const directory = pending.pop()!;
+let entries: fs.Dirent[];
+try {
+entries = await fs.promises.readdir(directory, { withFileTypes: true });
+} catch {
+continue;
+}
+for (const entry of entries) {
+if (entry.name.startsWith('.')) continue;
+const file = path.join(directory, entry.name);
+if (entry.isDirectory()) {
+if (!skippedDirectories.has(entry.name)) pending.push(file);
+} else if (entry.isFile() && entry.name.endsWith('.taml')) {
+yield file;
+}
+}
+}
+}
+
+function matches(text: string, query: string): boolean {
+let position = 0;
+for (const character of query) {
+position = text.indexOf(character, position) + 1;
+if (position === 0) return false;
+}
+return true;
+}
+
+function describe(type: ValueType): string {
+switch (type) {
+case 'boolean': return 'a boolean';
+case 'date': return 'a date';
+case 'number': return 'a number';
+default: return 'a string';
+}
+}
@@ -1,5 +1,5 @@
 import * as path from 'path';
-import { workspace, ExtensionContext } from 'vscode';
+import { workspace, window, ExtensionContext } from 'vscode';
 
 import {
 	LanguageClient,
@@ -34,6 +34,10 @@ export function activate(context: ExtensionContext) {
 		synchronize: {
 			// Notify the server about file changes to '.taml files contained in the workspace
 			fileEvents: workspace.createFileSystemWatcher('**/*.taml')
+		},
+		// Where the server caches its index of the workspace's TAML files
+		initializationOptions: {
+			storagePath: (context.storageUri ?? context.globalStorageUri).fsPath
 		}
 	};
 
@@ -45,8 +49,23 @@ export function activate(context: ExtensionContext) {
 		clientOptions
 	);
 
+	// Tell the server which documents are on screen, so it validates them first
+	const sendVisibleDocuments = () => {
+		if (!client.isRunning()) {
+			return;
+		}
+		client.sendNotification('taml/didChangeVisibleDocuments', {
+			active: window.activeTextEditor?.document.uri.toString(),
+			visible: window.visibleTextEditors.map(editor => editor.document.uri.toString())
+		});
+	};
+	context.subscriptions.push(
+		window.onDidChangeActiveTextEditor(sendVisibleDocuments),
+		window.onDidChangeVisibleTextEditors(sendVisibleDocuments)
+	);
+
 	// Start the client. This will also launch the server
-	client.start();
+	client.start().then(sendVisibleDocuments);
 }
 
 export function deactivate(): Thenable<void> | undefined {